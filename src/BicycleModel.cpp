@@ -0,0 +1,115 @@
+/**
+ * @file BicycleModel.cpp
+ * @author @jonatechout
+ * @brief Kinematic bicycle model with selectable integration scheme.
+ */
+#include "BicycleModel.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+/**
+ * @brief Controller which returns the same input for any state.
+ */
+struct ConstantInput
+{
+  BicycleModel::Input input;
+
+  BicycleModel::Input operator()(const BicycleModel::State &) const { return input; }
+};
+}
+
+BicycleModel::BicycleModel() : _wheelBase(2.5),
+                               _method(EULER),
+                               _maxSubStep(0.0),
+                               _maxHeadingStep(0.0)
+{
+}
+
+BicycleModel::~BicycleModel()
+{
+}
+
+void BicycleModel::setWheelBase(double wheelBase)
+{
+  this->_wheelBase = wheelBase;
+}
+
+void BicycleModel::setIntegrationMethod(IntegrationMethod method)
+{
+  this->_method = method;
+}
+
+void BicycleModel::setSubStepping(double maxSubStep, double maxHeadingStep)
+{
+  this->_maxSubStep = maxSubStep;
+  this->_maxHeadingStep = maxHeadingStep;
+}
+
+double BicycleModel::yawRate(double velocity, double tyreAngle) const
+{
+  return velocity * MathKernel::tan(tyreAngle) / _wheelBase;
+}
+
+void BicycleModel::integrate(State *state, const Input &input, double dt) const
+{
+  ConstantInput controller;
+  controller.input = input;
+
+  integrate(state, controller, dt);
+}
+
+int BicycleModel::subStepNum(const State &state, const Input &input, double dt) const
+{
+  const int maxSubStepNum = 100; //Upper limit of sub-steps in one period
+
+  int num = 1;
+
+  if (_maxSubStep > 0.0)
+  {
+    num = max(num, static_cast<int>(ceil(dt / _maxSubStep)));
+  }
+
+  if (_maxHeadingStep > 0.0)
+  {
+    // Estimate the heading change from the fastest velocity reached in this period
+    double maxVelocity = max(state.velocity, state.velocity + input.accel * dt);
+    double headingChange = fabs(yawRate(maxVelocity, input.tyreAngle)) * dt;
+    num = max(num, static_cast<int>(ceil(headingChange / _maxHeadingStep)));
+  }
+
+  return min(num, maxSubStepNum);
+}
+
+BicycleModel::State BicycleModel::derivative(const State &state, const Input &input) const
+{
+  double velocity = max(state.velocity, 0.0);
+
+  double sinHeading, cosHeading;
+  MathKernel::sinCos(state.heading, &sinHeading, &cosHeading);
+
+  State d;
+  d.x = velocity * cosHeading;
+  d.y = velocity * sinHeading;
+  d.heading = yawRate(velocity, input.tyreAngle);
+  d.distance = velocity;
+
+  // Car does not move backward
+  d.velocity = (velocity <= 0.0 && input.accel < 0.0) ? 0.0 : input.accel;
+
+  return d;
+}
+
+BicycleModel::State BicycleModel::advance(const State &state, const State &derivative, double dt)
+{
+  State s;
+  s.x = state.x + derivative.x * dt;
+  s.y = state.y + derivative.y * dt;
+  s.heading = state.heading + derivative.heading * dt;
+  s.velocity = state.velocity + derivative.velocity * dt;
+  s.distance = state.distance + derivative.distance * dt;
+
+  return s;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file BicycleModel.hpp
+ * @author @jonatechout
+ * @brief Kinematic bicycle model with selectable integration scheme.
+ */
+#ifndef BICYCLEMODEL_H
+#define BICYCLEMODEL_H
+
+#include <math.h>
+#include "MathKernel.hpp"
+
+/**
+ * @class BicycleModel
+ * @brief Kinematic bicycle model with selectable integration scheme.
+ * Inputs (acceleration and tyre angle) are given by a controller evaluated at every stage of the scheme,
+ * so the closed loop stays accurate when a long period is split into sub-steps.
+ */
+class BicycleModel
+{
+public:
+  enum IntegrationMethod
+  {
+    EULER,         ///< Explicit Euler (velocity first, heading from the previous velocity)
+    SEMI_IMPLICIT, ///< Semi-implicit Euler (velocity, then heading, then position)
+    RK4            ///< Classical 4th order Runge-Kutta
+  };
+
+  struct State
+  {
+    double x;        ///< X [m] (world coordinate)
+    double y;        ///< Y [m] (world coordinate)
+    double heading;  ///< Heading angle [rad] (world coordinate, east is 0)
+    double velocity; ///< Velocity [m/s]
+    double distance; ///< Travelled distance in the current period [m]
+  };
+
+  struct Input
+  {
+    double accel;     ///< Acceleration [m/s^2]
+    double tyreAngle; ///< Tyre angle [rad]
+  };
+
+  BicycleModel();
+  virtual ~BicycleModel();
+
+  /**
+   * @brief Set the Wheel base
+   *
+   * @param wheelBase [m]
+   */
+  void setWheelBase(double wheelBase);
+
+  /**
+   * @brief Set the Integration method
+   *
+   * @param method
+   */
+  void setIntegrationMethod(IntegrationMethod method);
+
+  /**
+   * @brief Set the sub-stepping limits. The period given to integrate() is split into equal sub-steps
+   * so that no sub-step exceeds either limit. 0 disables the limit.
+   *
+   * @param maxSubStep Maximum length of a sub-step [s]
+   * @param maxHeadingStep Maximum heading change in a sub-step [rad] (adaptive sub-stepping)
+   */
+  void setSubStepping(double maxSubStep, double maxHeadingStep);
+
+  /**
+   * @brief Integrate the state over given period with constant input.
+   *
+   * @param state State to update
+   * @param input Input held during the period
+   * @param dt Period [s]
+   */
+  void integrate(State *state, const Input &input, double dt) const;
+
+  /**
+   * @brief Integrate the state over given period with a state feedback controller.
+   * state->distance is reset to 0 at the beginning of the period.
+   *
+   * @param state State to update
+   * @param controller Functor which returns Input for given State
+   * @param dt Period [s]
+   */
+  template <class Controller>
+  void integrate(State *state, Controller controller, double dt) const;
+
+  /**
+   * @brief Returns yaw rate of the model.
+   *
+   * @param velocity [m/s]
+   * @param tyreAngle [rad]
+   * @return double Yaw rate [rad/s]
+   */
+  double yawRate(double velocity, double tyreAngle) const;
+
+protected:
+  /**
+   * @brief Returns the number of sub-steps for given period.
+   *
+   * @param state State at the beginning of the period
+   * @param input Input at the beginning of the period
+   * @param dt Period [s]
+   * @return int Number of sub-steps
+   */
+  int subStepNum(const State &state, const Input &input, double dt) const;
+
+  /**
+   * @brief Advance the state by one sub-step.
+   *
+   * @param state State to update
+   * @param controller Functor which returns Input for given State
+   * @param dt Sub-step [s]
+   */
+  template <class Controller>
+  void step(State *state, Controller &controller, double dt) const;
+
+  /**
+   * @brief Time derivative of the state. Velocity does not go below zero.
+   *
+   * @param state
+   * @param input
+   * @return State Derivative of each member
+   */
+  State derivative(const State &state, const Input &input) const;
+
+  /**
+   * @brief Returns state + derivative * dt
+   */
+  static State advance(const State &state, const State &derivative, double dt);
+
+  double _wheelBase;            ///< Wheel base [m]
+  IntegrationMethod _method;    ///< Integration method
+  double _maxSubStep;           ///< Maximum sub-step [s] (0: disabled)
+  double _maxHeadingStep;       ///< Maximum heading change per sub-step [rad] (0: disabled)
+};
+
+template <class Controller>
+void BicycleModel::integrate(State *state, Controller controller, double dt) const
+{
+  state->distance = 0.0;
+
+  int num = subStepNum(*state, controller(*state), dt);
+  double subStep = dt / num;
+
+  for (int i = 0; i < num; i++)
+  {
+    step(state, controller, subStep);
+  }
+}
+
+template <class Controller>
+void BicycleModel::step(State *state, Controller &controller, double dt) const
+{
+  switch (_method)
+  {
+  case EULER:
+  {
+    Input input = controller(*state);
+    double yawrate = yawRate(state->velocity, input.tyreAngle);
+
+    double sinHeading, cosHeading;
+    MathKernel::sinCos(state->heading, &sinHeading, &cosHeading);
+
+    state->velocity = state->velocity + input.accel * dt;
+    state->velocity = state->velocity > 0.0 ? state->velocity : 0.0;
+    state->x += state->velocity * cosHeading * dt;
+    state->y += state->velocity * sinHeading * dt;
+    state->heading += yawrate * dt;
+    state->distance += state->velocity * dt;
+    break;
+  }
+  case SEMI_IMPLICIT:
+  {
+    Input input = controller(*state);
+
+    state->velocity = state->velocity + input.accel * dt;
+    state->velocity = state->velocity > 0.0 ? state->velocity : 0.0;
+    state->heading += yawRate(state->velocity, input.tyreAngle) * dt;
+
+    double sinHeading, cosHeading;
+    MathKernel::sinCos(state->heading, &sinHeading, &cosHeading);
+
+    state->x += state->velocity * cosHeading * dt;
+    state->y += state->velocity * sinHeading * dt;
+    state->distance += state->velocity * dt;
+    break;
+  }
+  case RK4:
+  {
+    State k1 = derivative(*state, controller(*state));
+
+    State s2 = advance(*state, k1, dt * 0.5);
+    State k2 = derivative(s2, controller(s2));
+
+    State s3 = advance(*state, k2, dt * 0.5);
+    State k3 = derivative(s3, controller(s3));
+
+    State s4 = advance(*state, k3, dt);
+    State k4 = derivative(s4, controller(s4));
+
+    State k;
+    k.x = (k1.x + 2.0 * k2.x + 2.0 * k3.x + k4.x) / 6.0;
+    k.y = (k1.y + 2.0 * k2.y + 2.0 * k3.y + k4.y) / 6.0;
+    k.heading = (k1.heading + 2.0 * k2.heading + 2.0 * k3.heading + k4.heading) / 6.0;
+    k.velocity = (k1.velocity + 2.0 * k2.velocity + 2.0 * k3.velocity + k4.velocity) / 6.0;
+    k.distance = (k1.distance + 2.0 * k2.distance + 2.0 * k3.distance + k4.distance) / 6.0;
+
+    *state = advance(*state, k, dt);
+    state->velocity = state->velocity > 0.0 ? state->velocity : 0.0;
+    break;
+  }
+  }
+}
+
+#endif
@@ -34,6 +34,21 @@ void Car::setPeriod(double period)
   this->_periodTime = period;
 }
 
+void Car::setCurrentTime(double time)
+{
+  this->_currentTime = time;
+}
+
+bool Car::canSleep() const
+{
+  return false;
+}
+
+double Car::wakeUpTime() const
+{
+  return -1.0;
+}
+
 double Car::distanceTo(const Car& target) const
 {
   double distSq =
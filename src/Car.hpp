@@ -60,6 +60,35 @@ public:
 
   virtual void update() = 0;
 
+  /**
+   * @brief Returns true if the state does not change until the car is woken up.
+   * Evaluated after update(). Sleeping cars are not updated by EventScheduler.
+   *
+   * @return true  The car can sleep.
+   */
+  virtual bool canSleep() const;
+
+  /**
+   * @brief Returns the time when a sleeping car must wake up by itself (e.g. next measurement).
+   *
+   * @return double Time [s] (negative: only woken up by the leading car)
+   */
+  virtual double wakeUpTime() const;
+
+  /**
+   * @brief Returns the size of the object of the most derived class, without containers it owns.
+   *
+   * @return size_t [bytes]
+   */
+  virtual size_t objectSize() const { return sizeof(Car); }
+
+  /**
+   * @brief Set the current simulation time. Used to skip the period while sleeping.
+   *
+   * @param time [s]
+   */
+  void setCurrentTime(double time);
+
 protected:
   double _periodTime;   ///< Update period [s]
   double _currentTime;  ///< Current simulation time [s]
@@ -74,6 +103,7 @@ public:
   const double y() const { return _y; }
   const double velocity() const { return _velocity; }
   const double heading() const { return _heading; }
+  const double currentTime() const { return _currentTime; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+/**
+ * @file ConfigFile.cpp
+ * @author @jonatechout
+ * @brief Reads and writes simple "key = value" files with [section] headers.
+ */
+#include "ConfigFile.hpp"
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+ConfigFile::ConfigFile()
+{
+}
+
+ConfigFile::~ConfigFile()
+{
+}
+
+bool ConfigFile::load(const string &filepath)
+{
+  _sections.clear();
+
+  ifstream ifs(filepath.c_str());
+  if (ifs.fail())
+  {
+    cout << "Failed to open file: " << filepath << endl;
+    return false;
+  }
+
+  addSection("").line = 0;
+
+  string line;
+  int lineNum = 0;
+  while (getline(ifs, line))
+  {
+    lineNum++;
+
+    // Ignore comments
+    size_t comment = line.find('#');
+    if (comment != string::npos)
+    {
+      line.erase(comment);
+    }
+
+    line = trim(line);
+    if (line.empty())
+    {
+      continue;
+    }
+
+    if (line.front() == '[')
+    {
+      if (line.back() != ']')
+      {
+        cout << filepath << ":" << lineNum << ": Wrong section header" << endl;
+        return false;
+      }
+
+      addSection(trim(line.substr(1, line.size() - 2))).line = lineNum;
+      continue;
+    }
+
+    size_t equal = line.find('=');
+    if (equal == string::npos || trim(line.substr(0, equal)).empty())
+    {
+      cout << filepath << ":" << lineNum << ": Expected \"key = value\"" << endl;
+      return false;
+    }
+
+    _sections.back().entries.push_back(Entry(trim(line.substr(0, equal)), trim(line.substr(equal + 1))));
+  }
+
+  return true;
+}
+
+bool ConfigFile::save(const string &filepath) const
+{
+  ofstream ofs(filepath.c_str());
+  if (ofs.fail())
+  {
+    cout << "Failed to create file: " << filepath << endl;
+    return false;
+  }
+
+  for (const auto &section : _sections)
+  {
+    if (!section.name.empty())
+    {
+      ofs << endl << "[" << section.name << "]" << endl;
+    }
+
+    for (const auto &entry : section.entries)
+    {
+      ofs << entry.first << " = " << entry.second << endl;
+    }
+  }
+
+  return !ofs.fail();
+}
+
+ConfigFile::Section &ConfigFile::addSection(const string &name)
+{
+  Section section;
+  section.name = name;
+  section.line = 0;
+  _sections.push_back(section);
+
+  return _sections.back();
+}
+
+string ConfigFile::get(const string &section, const string &key, const string &defaultValue) const
+{
+  for (const auto &sec : _sections)
+  {
+    if (sec.name != section)
+    {
+      continue;
+    }
+
+    for (const auto &entry : sec.entries)
+    {
+      if (entry.first == key)
+      {
+        return entry.second;
+      }
+    }
+
+    break;
+  }
+
+  return defaultValue;
+}
+
+string ConfigFile::trim(const string &text)
+{
+  const char *spaces = " \t\r\n";
+
+  size_t begin = text.find_first_not_of(spaces);
+  if (begin == string::npos)
+  {
+    return "";
+  }
+
+  size_t end = text.find_last_not_of(spaces);
+  return text.substr(begin, end - begin + 1);
+}
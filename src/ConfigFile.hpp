@@ -0,0 +1,81 @@
+/**
+ * @file ConfigFile.hpp
+ * @author @jonatechout
+ * @brief Reads and writes simple "key = value" files with [section] headers.
+ */
+#ifndef CONFIGFILE_H
+#define CONFIGFILE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ConfigFile
+ * @brief Reads and writes simple "key = value" files with [section] headers.
+ * Text after '#' is a comment. Keys before the first section header belong to an unnamed section.
+ * A section name may appear several times (e.g. one [leader] section per leading car),
+ * sections and keys keep the order in the file.
+ */
+class ConfigFile
+{
+public:
+  typedef std::pair<std::string, std::string> Entry;
+
+  struct Section
+  {
+    std::string name;           ///< Section name (empty: before the first header)
+    std::vector<Entry> entries; ///< Keys and values
+    int line;                   ///< Line number of the header
+  };
+
+  ConfigFile();
+  virtual ~ConfigFile();
+
+  /**
+   * @brief Read a file.
+   *
+   * @param filepath
+   * @return true  File is read.
+   * @return false  Failed to open or syntax error.
+   */
+  bool load(const std::string &filepath);
+
+  /**
+   * @brief Write all the sections to a file.
+   *
+   * @param filepath
+   * @return true  File is written.
+   * @return false  Failed to write.
+   */
+  bool save(const std::string &filepath) const;
+
+  /**
+   * @brief Add a section at the end.
+   *
+   * @param name Section name
+   * @return Section& Added section
+   */
+  Section &addSection(const std::string &name);
+
+  /**
+   * @brief Returns the value of a key in the first section of given name.
+   *
+   * @param section Section name
+   * @param key
+   * @param defaultValue Value returned if not found
+   */
+  std::string get(const std::string &section, const std::string &key, const std::string &defaultValue) const;
+
+  const std::vector<Section> &sections() const { return _sections; }
+
+protected:
+  /**
+   * @brief Remove spaces at both ends.
+   */
+  static std::string trim(const std::string &text);
+
+  std::vector<Section> _sections; ///< Sections in the order of the file
+};
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file ControllerPolicy.hpp
+ * @author @jonatechout
+ * @brief Control laws of following cars. Longitudinal and lateral policies are combined in FollowerCar.
+ *
+ * A longitudinal policy provides
+ *   double targetAccel(const LongitudinalState &state) const;
+ * A lateral policy provides
+ *   double lookahead(double velocity) const;
+ *   double targetTyreAngle(const Car::PositionData &followPoint, const BicycleModel::State &state) const;
+ * Both provide
+ *   bool setParam(const std::string &name, double value);
+ * which sets a parameter by its member name (e.g. from a scenario file) and returns false for unknown names.
+ */
+#ifndef CONTROLLERPOLICY_H
+#define CONTROLLERPOLICY_H
+
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include "Car.hpp"
+#include "BicycleModel.hpp"
+#include "MathKernel.hpp"
+
+/**
+ * @brief Inputs of longitudinal control
+ */
+struct LongitudinalState
+{
+  double gap;            ///< Distance to the leading car along the path [m]
+  double velocity;       ///< Own velocity [m/s]
+  double leaderVelocity; ///< Velocity of the leading car [m/s]
+  double leaderAccel;    ///< Acceleration of the leading car [m/s^2]
+};
+
+/**
+ * @class LinearGapPolicy
+ * @brief Acceleration is linear to the gap error and the velocity difference.
+ */
+struct LinearGapPolicy
+{
+  double interVehicleTime; ///< Target inter-vehicle time to calculate the target distance to leading car [s]
+  double stopDistance;     ///< Distance to stop before leading car [m]
+  double accCoeffDist;     ///< Parameter of acceleration calculation
+  double accCoeffVel;      ///< Parameter of acceleration calculation
+  double emergencyDecel;   ///< Deceleration when the leading car is closer than stopDistance [m/s^2]
+
+  LinearGapPolicy() : interVehicleTime(3.0),
+                      stopDistance(5.0),
+                      accCoeffDist(0.05),
+                      accCoeffVel(0.4),
+                      emergencyDecel(5.0)
+  {
+  }
+
+  bool setParam(const std::string &name, double value)
+  {
+    double *param = (name == "interVehicleTime") ? &interVehicleTime :
+                    (name == "stopDistance") ? &stopDistance :
+                    (name == "accCoeffDist") ? &accCoeffDist :
+                    (name == "accCoeffVel") ? &accCoeffVel :
+                    (name == "emergencyDecel") ? &emergencyDecel : nullptr;
+    if (param != nullptr)
+    {
+      *param = value;
+    }
+    return param != nullptr;
+  }
+
+  double targetAccel(const LongitudinalState &state) const
+  {
+    if (state.gap < stopDistance)
+    {
+      // If the leading car is very close, decelerate strongly
+      return -emergencyDecel;
+    }
+
+    double targetRange = state.velocity * interVehicleTime + stopDistance;
+
+    return accCoeffDist * (state.gap - targetRange) + accCoeffVel * (state.leaderVelocity - state.velocity);
+  }
+};
+
+/**
+ * @class IdmPolicy
+ * @brief Intelligent Driver Model.
+ */
+struct IdmPolicy
+{
+  double desiredVelocity; ///< Velocity on free road [m/s]
+  double timeHeadway;     ///< Desired time headway [s]
+  double minGap;          ///< Gap at standstill [m]
+  double maxAccel;        ///< Maximum acceleration [m/s^2]
+  double comfortDecel;    ///< Comfortable deceleration [m/s^2]
+  double maxDecel;        ///< Limit of deceleration [m/s^2]
+  double exponent;        ///< Acceleration exponent
+
+  IdmPolicy() : desiredVelocity(20.0),
+                timeHeadway(1.5),
+                minGap(5.0),
+                maxAccel(1.0),
+                comfortDecel(2.0),
+                maxDecel(5.0),
+                exponent(4.0)
+  {
+  }
+
+  bool setParam(const std::string &name, double value)
+  {
+    double *param = (name == "desiredVelocity") ? &desiredVelocity :
+                    (name == "timeHeadway") ? &timeHeadway :
+                    (name == "minGap") ? &minGap :
+                    (name == "maxAccel") ? &maxAccel :
+                    (name == "comfortDecel") ? &comfortDecel :
+                    (name == "maxDecel") ? &maxDecel :
+                    (name == "exponent") ? &exponent : nullptr;
+    if (param != nullptr)
+    {
+      *param = value;
+    }
+    return param != nullptr;
+  }
+
+  double targetAccel(const LongitudinalState &state) const
+  {
+    const double minEffectiveGap = 0.1; // Avoid division by zero
+
+    double dv = state.velocity - state.leaderVelocity;
+    double desiredGap = minGap + std::max(0.0, state.velocity * timeHeadway +
+                                                   state.velocity * dv / (2.0 * sqrt(maxAccel * comfortDecel)));
+    double gapRatio = desiredGap / std::max(state.gap, minEffectiveGap);
+
+    double accel = maxAccel * (1.0 - pow(state.velocity / desiredVelocity, exponent) - gapRatio * gapRatio);
+
+    return std::max(accel, -maxDecel);
+  }
+};
+
+/**
+ * @class CaccPolicy
+ * @brief Cooperative adaptive cruise control. Uses the leading car's acceleration as feedforward.
+ */
+struct CaccPolicy
+{
+  double timeGap;       ///< Target time gap [s]
+  double standstillGap; ///< Gap at standstill [m]
+  double gainGap;       ///< Feedback gain of gap error
+  double gainVel;       ///< Feedback gain of velocity difference
+  double gainAccel;     ///< Feedforward gain of leader's acceleration
+  double maxAccel;      ///< Limit of acceleration [m/s^2]
+  double maxDecel;      ///< Limit of deceleration [m/s^2]
+
+  CaccPolicy() : timeGap(0.6),
+                 standstillGap(5.0),
+                 gainGap(0.2),
+                 gainVel(0.7),
+                 gainAccel(1.0),
+                 maxAccel(2.0),
+                 maxDecel(5.0)
+  {
+  }
+
+  bool setParam(const std::string &name, double value)
+  {
+    double *param = (name == "timeGap") ? &timeGap :
+                    (name == "standstillGap") ? &standstillGap :
+                    (name == "gainGap") ? &gainGap :
+                    (name == "gainVel") ? &gainVel :
+                    (name == "gainAccel") ? &gainAccel :
+                    (name == "maxAccel") ? &maxAccel :
+                    (name == "maxDecel") ? &maxDecel : nullptr;
+    if (param != nullptr)
+    {
+      *param = value;
+    }
+    return param != nullptr;
+  }
+
+  double targetAccel(const LongitudinalState &state) const
+  {
+    double gapError = state.gap - (standstillGap + timeGap * state.velocity);
+    double accel = gainAccel * state.leaderAccel + gainGap * gapError +
+                   gainVel * (state.leaderVelocity - state.velocity);
+
+    return std::min(std::max(accel, -maxDecel), maxAccel);
+  }
+};
+
+/**
+ * @class PurePursuitPolicy
+ * @brief Tyre angle is directly toward the point ahead on the leading car's path.
+ */
+struct PurePursuitPolicy
+{
+  double distToFollowPoint; ///< Distance to the point to follow on path [m]
+  double tyreAngleLimit;    ///< Limit of tyre angle [rad]
+
+  PurePursuitPolicy() : distToFollowPoint(5.0),
+                        tyreAngleLimit(30.0 * M_PI / 180.0)
+  {
+  }
+
+  bool setParam(const std::string &name, double value)
+  {
+    double *param = (name == "distToFollowPoint") ? &distToFollowPoint :
+                    (name == "tyreAngleLimit") ? &tyreAngleLimit : nullptr;
+    if (param != nullptr)
+    {
+      *param = value;
+    }
+    return param != nullptr;
+  }
+
+  double lookahead(double) const
+  {
+    return distToFollowPoint;
+  }
+
+  double targetTyreAngle(const Car::PositionData &followPoint, const BicycleModel::State &state) const
+  {
+    double sinHeading, cosHeading;
+    MathKernel::sinCos(state.heading, &sinHeading, &cosHeading);
+
+    // Follow point on car coordinate
+    double followX_c = cosHeading * (followPoint.x - state.x) + sinHeading * (followPoint.y - state.y);
+    double followY_c = -sinHeading * (followPoint.x - state.x) + cosHeading * (followPoint.y - state.y);
+
+    // Tyre angle is directly toward the follwPoint
+    double tyreAngle = MathKernel::atan2(followY_c, followX_c);
+
+    return std::min(std::max(tyreAngle, -tyreAngleLimit), tyreAngleLimit);
+  }
+};
+
+#endif
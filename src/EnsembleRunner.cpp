@@ -0,0 +1,399 @@
+/**
+ * @file EnsembleRunner.cpp
+ * @author @jonatechout
+ * @brief Runs perturbed copies of a platoon scenario in parallel and reduces their statistics online.
+ */
+#include "EnsembleRunner.hpp"
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include "PlaybackCar.hpp"
+#include "Simulation.hpp"
+#include "V2VBus.hpp"
+
+using namespace std;
+
+namespace
+{
+const unsigned int gapBinNum = 400;   //Histogram of gap covers 0 to 100 m at first, doubled when a gap is larger
+const double gapBinWidth = 0.25;      //[m]
+const unsigned int velBinNum = 400;   //Histogram of velocity covers 0 to 40 m/s at first, doubled when a velocity is larger
+const double velBinWidth = 0.1;       //[m/s]
+
+uint64_t splitMix64(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+}
+
+void EnsembleRunner::Accumulator::init(unsigned int binNum, double width)
+{
+  count = 0;
+  sum = 0.0;
+  sumSq = 0.0;
+  min = numeric_limits<double>::infinity();
+  max = -numeric_limits<double>::infinity();
+  binWidth = width;
+  bins.assign(binNum, 0);
+}
+
+void EnsembleRunner::Accumulator::add(double value)
+{
+  count++;
+  sum += value;
+  sumSq += value * value;
+  min = std::min(min, value);
+  max = std::max(max, value);
+
+  // Keep the histogram over all the values, otherwise percentiles of large values stick to the last bin
+  while (isfinite(value) && value >= bins.size() * binWidth)
+  {
+    coarsen();
+  }
+
+  long long bin = static_cast<long long>(floor(value / binWidth));
+  bins.at(std::min(std::max(bin, 0LL), static_cast<long long>(bins.size()) - 1))++;
+}
+
+void EnsembleRunner::Accumulator::merge(const Accumulator &other)
+{
+  count += other.count;
+  sum += other.sum;
+  sumSq += other.sumSq;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+
+  // Both widths are the initial width times a power of 2, so the finer histogram is coarsened to the other
+  while (binWidth < other.binWidth)
+  {
+    coarsen();
+  }
+
+  Accumulator coarser = other;
+  while (coarser.binWidth < binWidth)
+  {
+    coarser.coarsen();
+  }
+
+  for (unsigned int i = 0; i < bins.size(); i++)
+  {
+    bins.at(i) += coarser.bins.at(i);
+  }
+}
+
+void EnsembleRunner::Accumulator::coarsen()
+{
+  for (unsigned int i = 0; i < bins.size(); i++)
+  {
+    bins.at(i) = (i * 2 < bins.size()) ? bins.at(i * 2) + ((i * 2 + 1 < bins.size()) ? bins.at(i * 2 + 1) : 0) : 0;
+  }
+
+  binWidth *= 2.0;
+}
+
+EnsembleRunner::Summary EnsembleRunner::Accumulator::summarize() const
+{
+  const double ratios[3] = {0.05, 0.5, 0.95};
+
+  Summary summary;
+  summary.count = count;
+
+  if (count == 0)
+  {
+    summary.mean = summary.stdDev = summary.min = summary.max = 0.0;
+    summary.p5 = summary.p50 = summary.p95 = 0.0;
+    return summary;
+  }
+
+  summary.mean = sum / count;
+  summary.stdDev = sqrt(std::max(sumSq / count - summary.mean * summary.mean, 0.0));
+  summary.min = min;
+  summary.max = max;
+
+  // Interpolate percentiles within the bin, assuming values are uniformly distributed in it
+  double percentiles[3];
+  for (int k = 0; k < 3; k++)
+  {
+    double target = ratios[k] * count;
+    unsigned long long cumulative = 0;
+    unsigned int i = 0;
+
+    while (i < bins.size() - 1 && cumulative + bins.at(i) < target)
+    {
+      cumulative += bins.at(i);
+      i++;
+    }
+
+    double fraction = (bins.at(i) > 0) ? (target - cumulative) / bins.at(i) : 0.0;
+    percentiles[k] = std::min(std::max((i + fraction) * binWidth, min), max);
+  }
+
+  summary.p5 = percentiles[0];
+  summary.p50 = percentiles[1];
+  summary.p95 = percentiles[2];
+
+  return summary;
+}
+
+EnsembleRunner::EnsembleRunner() : _memberNum(100),
+                                   _threadNum(0),
+                                   _seed(0),
+                                   _scenario(),
+                                   _periodTime(0.02),
+                                   _sampleInterval(0.5)
+{
+  _perturbation.positionNoise = 0.2;
+  _perturbation.dropoutRate = 0.05;
+  _perturbation.processNoiseMin = 0.05;
+  _perturbation.processNoiseMax = 0.2;
+  _perturbation.measurementNoiseMin = 0.25;
+  _perturbation.measurementNoiseMax = 1.0;
+}
+
+EnsembleRunner::~EnsembleRunner()
+{
+}
+
+void EnsembleRunner::setMemberNum(unsigned int memberNum)
+{
+  _memberNum = memberNum;
+}
+
+void EnsembleRunner::setThreadNum(unsigned int threadNum)
+{
+  _threadNum = threadNum;
+}
+
+void EnsembleRunner::setSeed(uint64_t seed)
+{
+  _seed = seed;
+}
+
+void EnsembleRunner::setPerturbation(const Perturbation &perturbation)
+{
+  _perturbation = perturbation;
+}
+
+bool EnsembleRunner::setScenario(const Scenario &scenario)
+{
+  if (scenario.leaders.empty())
+  {
+    cout << "No leader in scenario" << endl;
+    return false;
+  }
+
+  // Build the followers once to find wrong controllers before running
+  vector<unique_ptr<SimCar> > followers;
+  string error;
+  if (!Simulation::createFollowers(scenario, 0, &followers, &error))
+  {
+    cout << error << endl;
+    return false;
+  }
+
+  if (scenario.laneNum > 1 || !scenario.maneuvers.empty())
+  {
+    // Statistics go to stdout as CSV
+    cerr << "Lanes and maneuvers are not simulated in ensemble, followers follow the path of their leading cars" << endl;
+  }
+
+  _scenario = scenario;
+  _periodTime = scenario.period;
+
+  return true;
+}
+
+void EnsembleRunner::setSampleInterval(double interval)
+{
+  _sampleInterval = interval;
+}
+
+bool EnsembleRunner::run(const vector<Car::PositionData> &data, double duration, vector<SampleStatistics> *out_stats)
+{
+  out_stats->clear();
+
+  if (data.empty())
+  {
+    return false;
+  }
+
+  if (duration <= 0.0)
+  {
+    duration = data.back().timestamp - data.front().timestamp;
+  }
+
+  long long tickNum = static_cast<long long>(floor(duration / _periodTime + 0.5));
+  long long sampleTicks = max(static_cast<long long>(floor(_sampleInterval / _periodTime + 0.5)), 1LL);
+  unsigned int sampleNum = tickNum / sampleTicks;
+
+  SampleAccumulator empty;
+  empty.gap.init(gapBinNum, gapBinWidth);
+  empty.velocity.init(velBinNum, velBinWidth);
+
+  // Each worker has its own accumulators, merged after all the members
+  unsigned int threadNum = (_threadNum > 0) ? _threadNum : max(thread::hardware_concurrency(), 1u);
+  threadNum = max(min(threadNum, _memberNum), 1u);
+
+  vector<vector<SampleAccumulator> > workerSamples(threadNum, vector<SampleAccumulator>(sampleNum, empty));
+  atomic<unsigned int> nextMember(0);
+
+  auto work = [&](unsigned int workerIndex) {
+    vector<Car::PositionData> buffer;
+    unsigned int member;
+    while ((member = nextMember.fetch_add(1)) < _memberNum)
+    {
+      runMember(member, data, tickNum, sampleTicks, &buffer, &workerSamples.at(workerIndex));
+    }
+  };
+
+  vector<thread> workers;
+  for (unsigned int i = 1; i < threadNum; i++)
+  {
+    workers.push_back(thread(work, i));
+  }
+
+  work(0);
+
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  vector<SampleAccumulator> &samples = workerSamples.at(0);
+  for (unsigned int i = 1; i < threadNum; i++)
+  {
+    for (unsigned int j = 0; j < sampleNum; j++)
+    {
+      samples.at(j).gap.merge(workerSamples.at(i).at(j).gap);
+      samples.at(j).velocity.merge(workerSamples.at(i).at(j).velocity);
+    }
+  }
+
+  out_stats->resize(sampleNum);
+  for (unsigned int j = 0; j < sampleNum; j++)
+  {
+    SampleStatistics &stats = out_stats->at(j);
+    stats.time = (j + 1) * sampleTicks * _periodTime;
+    stats.gap = samples.at(j).gap.summarize();
+    stats.velocity = samples.at(j).velocity.summarize();
+  }
+
+  return true;
+}
+
+void EnsembleRunner::runMember(unsigned int memberIndex, const vector<Car::PositionData> &data, long long tickNum, long long sampleTicks,
+                               vector<Car::PositionData> *buffer, vector<SampleAccumulator> *out_samples) const
+{
+  // Independent stream of each member
+  mt19937_64 rng(splitMix64(_seed ^ splitMix64(memberIndex)));
+  normal_distribution<double> noise(0.0, max(_perturbation.positionNoise, 0.0));
+  uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  // Perturb INS data. The first sample is kept to start at the same time.
+  buffer->clear();
+  for (unsigned int i = 0; i < data.size(); i++)
+  {
+    if (i > 0 && uniform(rng) < _perturbation.dropoutRate)
+    {
+      continue;
+    }
+
+    Car::PositionData pos = data.at(i);
+    if (_perturbation.positionNoise > 0.0)
+    {
+      pos.x += noise(rng);
+      pos.y += noise(rng);
+    }
+    buffer->push_back(pos);
+  }
+
+  double processNoise = _perturbation.processNoiseMin +
+                        (_perturbation.processNoiseMax - _perturbation.processNoiseMin) * uniform(rng);
+  double measurementNoise = _perturbation.measurementNoiseMin +
+                            (_perturbation.measurementNoiseMax - _perturbation.measurementNoiseMin) * uniform(rng);
+
+  PlaybackCar egoCar;
+  egoCar.setData(*buffer);
+  egoCar.init(data.front().x, data.front().y, 0, 0);
+  egoCar.setPeriod(_periodTime);
+  egoCar.setKalmanNoise(processNoise, measurementNoise);
+  egoCar.initKalman();
+
+  // Followers as in the scenario (checked by setScenario), vehicle IDs: ego car 0, followers 1, 2, ...
+  vector<unique_ptr<SimCar> > followers;
+  string error;
+  Simulation::createFollowers(_scenario, 0, &followers, &error);
+
+  // V2V delay and loss of each member come from its own stream
+  V2VBus bus;
+  bus.setChannel(_scenario.v2vLatency, _scenario.v2vJitter, _scenario.v2vDropRate);
+  bus.setSeed(rng());
+  bus.init(followers.size() + 1, _periodTime);
+
+  for (unsigned int i = 0; i < followers.size(); i++)
+  {
+    followers.at(i)->init(data.front().x, data.front().y, 0, 0);
+    followers.at(i)->setPeriod(_periodTime);
+    followers.at(i)->setLeadingCar((i == 0) ? static_cast<const Car *>(&egoCar) : followers.at(i - 1).get());
+    followers.at(i)->setV2VBus(&bus, i + 1, i);
+  }
+
+  for (long long tick = 1; tick <= tickNum; tick++)
+  {
+    bus.advanceTo(tick);
+
+    egoCar.update();
+    bus.publish(0, egoCar);
+
+    for (unsigned int i = 0; i < followers.size(); i++)
+    {
+      followers.at(i)->update();
+      bus.publish(i + 1, *followers.at(i));
+    }
+
+    if (tick % sampleTicks != 0 || tick / sampleTicks > static_cast<long long>(out_samples->size()))
+    {
+      continue;
+    }
+
+    SampleAccumulator &sample = out_samples->at(tick / sampleTicks - 1);
+
+    double minGap = -1.0;
+    for (const auto &follower : followers)
+    {
+      if (follower->gap() >= 0.0 && (minGap < 0.0 || follower->gap() < minGap))
+      {
+        minGap = follower->gap();
+      }
+    }
+
+    if (minGap >= 0.0)
+    {
+      sample.gap.add(minGap);
+    }
+
+    sample.velocity.add(followers.empty() ? egoCar.velocity() : followers.back()->velocity());
+  }
+}
+
+void EnsembleRunner::writeCsv(const vector<SampleStatistics> &stats, ostream &out)
+{
+  out << "time,count,gap_mean,gap_std,gap_min,gap_p5,gap_p50,gap_p95,gap_max,"
+      << "vel_mean,vel_std,vel_min,vel_p5,vel_p50,vel_p95,vel_max" << endl;
+
+  for (const auto &s : stats)
+  {
+    out << s.time << "," << s.gap.count << ","
+        << s.gap.mean << "," << s.gap.stdDev << "," << s.gap.min << "," << s.gap.p5 << ","
+        << s.gap.p50 << "," << s.gap.p95 << "," << s.gap.max << ","
+        << s.velocity.mean << "," << s.velocity.stdDev << "," << s.velocity.min << "," << s.velocity.p5 << ","
+        << s.velocity.p50 << "," << s.velocity.p95 << "," << s.velocity.max << endl;
+  }
+}
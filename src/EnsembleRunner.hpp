@@ -0,0 +1,157 @@
+/**
+ * @file EnsembleRunner.hpp
+ * @author @jonatechout
+ * @brief Runs perturbed copies of a platoon scenario in parallel and reduces their statistics online.
+ */
+#ifndef ENSEMBLERUNNER_H
+#define ENSEMBLERUNNER_H
+
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include "Car.hpp"
+#include "Scenario.hpp"
+
+/**
+ * @class EnsembleRunner
+ * @brief Runs perturbed copies of a platoon scenario in parallel and reduces their statistics online.
+ * Each member plays the same INS data with injected position noise and dropouts, and with Kalman filter
+ * covariances drawn from given ranges. Random numbers of each member come from its own stream seeded by
+ * the member index, so results do not depend on the number of threads.
+ * Followers and V2V channel are the ones of the first leader of a scenario (lanes and maneuvers are not simulated).
+ * Statistics are accumulated while members run (moments and a histogram of fixed number of bins per sample),
+ * so memory does not grow with the number of members.
+ */
+class EnsembleRunner
+{
+public:
+  struct Perturbation
+  {
+    double positionNoise;       ///< Standard deviation of noise added to INS position [m]
+    double dropoutRate;         ///< Probability of losing an INS sample [0-1]
+    double processNoiseMin;     ///< Minimum process noise of Kalman filter per second
+    double processNoiseMax;     ///< Maximum process noise of Kalman filter per second
+    double measurementNoiseMin; ///< Minimum measurement noise of Kalman filter [m^2]
+    double measurementNoiseMax; ///< Maximum measurement noise of Kalman filter [m^2]
+  };
+
+  struct Summary
+  {
+    unsigned long long count; ///< Number of values
+    double mean;              ///< Mean
+    double stdDev;            ///< Standard deviation
+    double min;               ///< Minimum
+    double max;               ///< Maximum
+    double p5;                ///< 5th percentile
+    double p50;               ///< Median
+    double p95;               ///< 95th percentile
+  };
+
+  struct SampleStatistics
+  {
+    double time;      ///< Simulation time [s]
+    Summary gap;      ///< Minimum gap between cars in the platoon [m]
+    Summary velocity; ///< Velocity of the last follower [m/s]
+  };
+
+  EnsembleRunner();
+  virtual ~EnsembleRunner();
+
+  void setMemberNum(unsigned int memberNum);
+
+  /**
+   * @brief Set the number of threads.
+   *
+   * @param threadNum Number of threads (0: number of hardware threads)
+   */
+  void setThreadNum(unsigned int threadNum);
+
+  void setSeed(uint64_t seed);
+  void setPerturbation(const Perturbation &perturbation);
+
+  /**
+   * @brief Set the platoon to run: followers of the first leader, update period and V2V channel.
+   *
+   * @param scenario
+   * @return true  Followers can be built.
+   * @return false  No leader, unknown controller or parameter.
+   */
+  bool setScenario(const Scenario &scenario);
+
+  /**
+   * @brief Set the interval of statistics samples
+   *
+   * @param interval [sec]
+   */
+  void setSampleInterval(double interval);
+
+  /**
+   * @brief Run all the members.
+   *
+   * @param data INS position data of the leading car
+   * @param duration Simulation time [s] (0: until the end of data)
+   * @param out_stats Statistics of each sample
+   * @return true  Succeeded.
+   * @return false  No data.
+   */
+  bool run(const std::vector<Car::PositionData> &data, double duration, std::vector<SampleStatistics> *out_stats);
+
+  /**
+   * @brief Write statistics as CSV.
+   *
+   * @param stats Statistics of each sample
+   * @param out Output stream
+   */
+  static void writeCsv(const std::vector<SampleStatistics> &stats, std::ostream &out);
+
+protected:
+  /**
+   * @brief Streaming accumulator of a value. Percentiles are interpolated from the histogram.
+   * The width of the bins is doubled (pairs of bins are merged) when a value is beyond the last bin.
+   */
+  struct Accumulator
+  {
+    unsigned long long count;     ///< Number of values
+    double sum;                   ///< Sum of values
+    double sumSq;                 ///< Sum of squared values
+    double min;                   ///< Minimum
+    double max;                   ///< Maximum
+    double binWidth;              ///< Width of a histogram bin
+    std::vector<uint32_t> bins;   ///< Histogram from 0 (negative values go to the first bin)
+
+    void init(unsigned int binNum, double width);
+    void add(double value);
+    void merge(const Accumulator &other);
+    void coarsen(); ///< Merge pairs of bins and double the width
+    Summary summarize() const;
+  };
+
+  struct SampleAccumulator
+  {
+    Accumulator gap;      ///< Minimum gap between cars in the platoon
+    Accumulator velocity; ///< Velocity of the last follower
+  };
+
+  /**
+   * @brief Run a member and add its values to accumulators.
+   *
+   * @param memberIndex Index of the member, selects the random stream
+   * @param data INS position data of the leading car
+   * @param tickNum Number of ticks to simulate
+   * @param sampleTicks Number of ticks between samples
+   * @param buffer Buffer for perturbed data (reused between members)
+   * @param out_samples Accumulators of each sample
+   */
+  void runMember(unsigned int memberIndex, const std::vector<Car::PositionData> &data, long long tickNum, long long sampleTicks,
+                 std::vector<Car::PositionData> *buffer, std::vector<SampleAccumulator> *out_samples) const;
+
+  unsigned int _memberNum;     ///< Number of members
+  unsigned int _threadNum;     ///< Number of threads (0: number of hardware threads)
+  uint64_t _seed;              ///< Random seed
+  Perturbation _perturbation;  ///< Perturbation of members
+  Scenario _scenario;          ///< Followers of the first leader and V2V channel
+  double _periodTime;          ///< Update period [s]
+  double _sampleInterval;      ///< Interval of statistics samples [s]
+};
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file EventScheduler.cpp
+ * @author @jonatechout
+ * @brief Updates cars only when measurements arrive or controllers need to run.
+ */
+#include "EventScheduler.hpp"
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+EventScheduler::EventScheduler() : _periodTime(0.02),
+                                   _tick(0),
+                                   _updateCount(0)
+{
+}
+
+EventScheduler::~EventScheduler()
+{
+}
+
+void EventScheduler::setPeriod(double period)
+{
+  _periodTime = period;
+}
+
+unsigned int EventScheduler::addCar(Car *car, int leaderIndex)
+{
+  unsigned int index = _cars.size();
+
+  _cars.push_back(car);
+  _leaders.push_back(-1);
+  _followers.push_back(vector<unsigned int>());
+  _pendingTicks.push_back(-1);
+
+  setLeader(index, leaderIndex);
+
+  return index;
+}
+
+void EventScheduler::setLeader(unsigned int carIndex, int leaderIndex)
+{
+  int oldLeader = _leaders.at(carIndex);
+  if (oldLeader >= 0)
+  {
+    vector<unsigned int> &followers = _followers.at(oldLeader);
+    followers.erase(remove(followers.begin(), followers.end(), carIndex), followers.end());
+  }
+
+  _leaders.at(carIndex) = leaderIndex;
+  if (leaderIndex >= 0)
+  {
+    _followers.at(leaderIndex).push_back(carIndex);
+  }
+
+  wake(carIndex);
+}
+
+void EventScheduler::wake(unsigned int carIndex)
+{
+  schedule(carIndex, _tick + 1, CONTROL);
+}
+
+void EventScheduler::setTickCallback(TickCallback callback)
+{
+  _tickCallback = callback;
+}
+
+void EventScheduler::setUpdateCallback(UpdateCallback callback)
+{
+  _updateCallback = callback;
+}
+
+void EventScheduler::runUntil(double time)
+{
+  long long endTick = static_cast<long long>(floor(time / _periodTime + 0.5));
+
+  while (_tick < endTick)
+  {
+    // Skip the ticks without any event
+    long long nextTick = endTick;
+    if (!_queue.empty())
+    {
+      nextTick = min(max(_queue.top().tick, _tick + 1), endTick);
+    }
+
+    _tick = nextTick;
+
+    if (_tickCallback)
+    {
+      _tickCallback(_tick);
+    }
+
+    while (!_queue.empty() && _queue.top().tick <= _tick)
+    {
+      Event event = _queue.top();
+      _queue.pop();
+
+      // Skip the event replaced by an earlier one
+      if (_pendingTicks.at(event.carIndex) != event.tick)
+      {
+        continue;
+      }
+
+      process(event);
+    }
+  }
+}
+
+unsigned int EventScheduler::sleepingNum() const
+{
+  unsigned int num = 0;
+  for (auto pendingTick : _pendingTicks)
+  {
+    if (pendingTick < 0 || pendingTick > _tick + 1)
+    {
+      num++;
+    }
+  }
+
+  return num;
+}
+
+size_t EventScheduler::memoryUsage() const
+{
+  size_t bytes = _cars.capacity() * sizeof(Car *) +
+                 _leaders.capacity() * sizeof(int) +
+                 _followers.capacity() * sizeof(vector<unsigned int>) +
+                 _pendingTicks.capacity() * sizeof(long long) +
+                 _queue.size() * sizeof(Event);
+
+  for (const auto &followers : _followers)
+  {
+    bytes += followers.capacity() * sizeof(unsigned int);
+  }
+
+  return bytes;
+}
+
+void EventScheduler::schedule(unsigned int carIndex, long long tick, EventType type)
+{
+  long long &pendingTick = _pendingTicks.at(carIndex);
+  if (pendingTick >= 0 && pendingTick <= tick)
+  {
+    return;
+  }
+
+  pendingTick = tick;
+
+  Event event;
+  event.tick = tick;
+  event.carIndex = carIndex;
+  event.type = type;
+
+  _queue.push(event);
+}
+
+void EventScheduler::process(const Event &event)
+{
+  unsigned int index = event.carIndex;
+  Car *car = _cars.at(index);
+
+  _pendingTicks.at(index) = -1;
+
+  // Skip the period while sleeping
+  car->setCurrentTime((event.tick - 1) * _periodTime);
+  car->update();
+  _updateCount++;
+
+  if (_updateCallback)
+  {
+    _updateCallback(index, car);
+  }
+
+  if (car->canSleep())
+  {
+    double wakeUpTime = car->wakeUpTime();
+    if (wakeUpTime >= 0.0)
+    {
+      long long wakeUpTick = static_cast<long long>(ceil(wakeUpTime / _periodTime - 1e-9));
+      schedule(index, max(wakeUpTick, event.tick + 1), MEASUREMENT);
+    }
+
+    return;
+  }
+
+  schedule(index, event.tick + 1, CONTROL);
+
+  // Wake up the followers. Followers added later are updated in the same tick.
+  for (auto follower : _followers.at(index))
+  {
+    schedule(follower, (follower > index) ? event.tick : event.tick + 1, CONTROL);
+  }
+}
@@ -0,0 +1,135 @@
+/**
+ * @file EventScheduler.hpp
+ * @author @jonatechout
+ * @brief Updates cars only when measurements arrive or controllers need to run.
+ */
+#ifndef EVENTSCHEDULER_H
+#define EVENTSCHEDULER_H
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include "Car.hpp"
+
+/**
+ * @class EventScheduler
+ * @brief Updates cars only when measurements arrive or controllers need to run.
+ * Time advances in ticks of the update period. An awake car is updated every tick.
+ * After an update, a car which can sleep (see Car::canSleep()) is not updated again until
+ * its own wake-up time (measurement arrival) or until its leading car moves.
+ * Within a tick, cars are updated in the order they were added, so leading cars must be added first.
+ */
+class EventScheduler
+{
+public:
+  enum EventType
+  {
+    MEASUREMENT, ///< Car wakes up for its next measurement
+    CONTROL      ///< Car is updated in the next tick, or is woken up by its leading car
+  };
+
+  struct Event
+  {
+    long long tick;        ///< Tick to process the event
+    unsigned int carIndex; ///< Index of the car
+    EventType type;        ///< Type of the event
+  };
+
+  typedef std::function<void(long long tick)> TickCallback;
+  typedef std::function<void(unsigned int carIndex, Car *car)> UpdateCallback;
+
+  EventScheduler();
+  virtual ~EventScheduler();
+
+  /**
+   * @brief Set the update period
+   *
+   * @param period [sec]
+   */
+  void setPeriod(double period);
+
+  /**
+   * @brief Add a car. The car is updated from the next tick.
+   *
+   * @param car Car to update
+   * @param leaderIndex Index of the leading car which wakes this car up (-1: none)
+   * @return unsigned int Index of the car
+   */
+  unsigned int addCar(Car *car, int leaderIndex);
+
+  /**
+   * @brief Change the leading car which wakes the car up. The car is woken up.
+   *
+   * @param carIndex Index of the car
+   * @param leaderIndex Index of the new leading car (-1: none)
+   */
+  void setLeader(unsigned int carIndex, int leaderIndex);
+
+  /**
+   * @brief Update the car at the next tick even if it is sleeping.
+   *
+   * @param carIndex Index of the car
+   */
+  void wake(unsigned int carIndex);
+
+  /**
+   * @brief Set the function called when time advances, before the cars are updated.
+   */
+  void setTickCallback(TickCallback callback);
+
+  /**
+   * @brief Set the function called after each car update.
+   */
+  void setUpdateCallback(UpdateCallback callback);
+
+  /**
+   * @brief Process all the events until given time.
+   *
+   * @param time [s]
+   */
+  void runUntil(double time);
+
+  long long tick() const { return _tick; }
+  double currentTime() const { return _tick * _periodTime; }
+  unsigned long long updateCount() const { return _updateCount; }
+  unsigned int sleepingNum() const;
+
+  /**
+   * @brief Returns bytes of car lists and pending events.
+   */
+  size_t memoryUsage() const;
+
+protected:
+  struct EventLater
+  {
+    bool operator()(const Event &a, const Event &b) const
+    {
+      return (a.tick != b.tick) ? a.tick > b.tick : a.carIndex > b.carIndex;
+    }
+  };
+
+  /**
+   * @brief Schedule an event of a car. An event earlier than the pending one replaces it.
+   */
+  void schedule(unsigned int carIndex, long long tick, EventType type);
+
+  /**
+   * @brief Update a car and schedule its next event.
+   */
+  void process(const Event &event);
+
+  double _periodTime;  ///< Update period [s]
+  long long _tick;     ///< Current tick
+
+  std::vector<Car *> _cars;                             ///< Cars to update
+  std::vector<int> _leaders;                            ///< Index of the leading car of each car (-1: none)
+  std::vector<std::vector<unsigned int> > _followers;   ///< Indices of the cars woken up by each car
+  std::vector<long long> _pendingTicks;                 ///< Tick of the pending event of each car (-1: none)
+  std::priority_queue<Event, std::vector<Event>, EventLater> _queue; ///< Pending events
+
+  TickCallback _tickCallback;     ///< Called when time advances
+  UpdateCallback _updateCallback; ///< Called after each car update
+  unsigned long long _updateCount; ///< Total number of car updates
+};
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file FollowerCar.hpp
+ * @author @jonatechout
+ * @brief Following car whose control laws are given as template parameters.
+ */
+#ifndef FOLLOWERCAR_H
+#define FOLLOWERCAR_H
+
+#include "SimCar.hpp"
+#include "ControllerPolicy.hpp"
+
+/**
+ * @class FollowerCar
+ * @brief Following car whose control laws are given as template parameters.
+ * update() is final, so calls on a FollowerCar object are resolved at compile time
+ * and the control laws are inlined into the integration.
+ *
+ * @tparam LongitudinalPolicy Policy which gives acceleration (e.g. LinearGapPolicy)
+ * @tparam LateralPolicy Policy which gives tyre angle (e.g. PurePursuitPolicy)
+ */
+template <class LongitudinalPolicy, class LateralPolicy>
+class FollowerCar : public SimCar
+{
+public:
+  FollowerCar() : _longitudinal(), _lateral() {}
+  virtual ~FollowerCar() {}
+
+  /**
+   * @brief Update vehicle state.
+   */
+  virtual void update() final;
+
+  virtual size_t objectSize() const { return sizeof(*this); }
+
+  /**
+   * @brief Set a parameter of the longitudinal or lateral policy by its name.
+   */
+  virtual bool setControllerParam(const std::string &name, double value)
+  {
+    return _longitudinal.setParam(name, value) || _lateral.setParam(name, value);
+  }
+
+  /**
+   * @brief Get the longitudinal policy to modify its parameters.
+   */
+  LongitudinalPolicy &longitudinal() { return _longitudinal; }
+
+  /**
+   * @brief Get the lateral policy to modify its parameters.
+   */
+  LateralPolicy &lateral() { return _lateral; }
+
+protected:
+  LongitudinalPolicy _longitudinal; ///< Longitudinal control law
+  LateralPolicy _lateral;           ///< Lateral control law
+};
+
+typedef FollowerCar<LinearGapPolicy, PurePursuitPolicy> LinearFollowerCar;
+typedef FollowerCar<IdmPolicy, PurePursuitPolicy> IdmFollowerCar;
+typedef FollowerCar<CaccPolicy, PurePursuitPolicy> CaccFollowerCar;
+
+template <class LongitudinalPolicy, class LateralPolicy>
+void FollowerCar<LongitudinalPolicy, LateralPolicy>::update()
+{
+  PositionData followPoint;
+  LongitudinalState observed;
+
+  if (!observeLeadingCar(_lateral.lookahead(_velocity), &followPoint, &observed))
+  {
+    return;
+  }
+
+  // Control laws are evaluated at every integration stage, leading car's state is held during the period.
+  integrateMotion([&](const BicycleModel::State &state) -> BicycleModel::Input
+  {
+    LongitudinalState longitudinalState = observed;
+    longitudinalState.gap -= state.distance;
+    longitudinalState.velocity = state.velocity;
+
+    BicycleModel::Input input;
+    input.accel = _longitudinal.targetAccel(longitudinalState);
+    input.tyreAngle = _lateral.targetTyreAngle(followPoint, state);
+
+    return input;
+  });
+}
+
+#endif
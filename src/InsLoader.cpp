@@ -0,0 +1,273 @@
+/**
+ * @file InsLoader.cpp
+ * @author @jonatechout
+ * @brief Loads INS files (Oxford robotcar dataset) in parallel and aligns them on a common origin.
+ */
+#include "InsLoader.hpp"
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+InsLoader::InsLoader() : _threadNum(0)
+{
+}
+
+InsLoader::~InsLoader()
+{
+}
+
+void InsLoader::setThreadNum(unsigned int threadNum)
+{
+  _threadNum = threadNum;
+}
+
+bool InsLoader::load(const vector<vector<string> > &drives, vector<vector<Car::PositionData> > *out_drives)
+{
+  out_drives->clear();
+
+  vector<vector<InsRecord> > records(drives.size());
+  for (unsigned int i = 0; i < drives.size(); i++)
+  {
+    if (!loadDrive(drives.at(i), &records.at(i)))
+    {
+      return false;
+    }
+  }
+
+  // The earliest sample of all the drives becomes the origin
+  const InsRecord *origin = nullptr;
+  for (const auto &drive : records)
+  {
+    if (!drive.empty() && (origin == nullptr || drive.front().timestamp < origin->timestamp))
+    {
+      origin = &drive.front();
+    }
+  }
+
+  out_drives->resize(drives.size());
+
+  if (origin == nullptr)
+  {
+    return true;
+  }
+
+  for (unsigned int i = 0; i < records.size(); i++)
+  {
+    vector<Car::PositionData> &data = out_drives->at(i);
+    data.reserve(records.at(i).size());
+
+    for (const auto &rec : records.at(i))
+    {
+      Car::PositionData pos;
+
+      //Calculate time difference from first timestamp
+      pos.timestamp = static_cast<double>(rec.timestamp - origin->timestamp) * 1e-6; //[sec]
+      pos.x = rec.easting - origin->easting;
+      pos.y = rec.northing - origin->northing;
+
+      data.push_back(pos);
+    }
+  }
+
+  return true;
+}
+
+bool InsLoader::load(const vector<string> &files, vector<Car::PositionData> *out_data)
+{
+  vector<vector<string> > drives(1, files);
+  vector<vector<Car::PositionData> > data;
+
+  if (!load(drives, &data))
+  {
+    out_data->clear();
+    return false;
+  }
+
+  out_data->swap(data.front());
+
+  return true;
+}
+
+bool InsLoader::loadDrive(const vector<string> &files, vector<InsRecord> *out_records)
+{
+  out_records->clear();
+
+  for (const auto &file : files)
+  {
+    if (!loadFile(file, out_records))
+    {
+      out_records->clear();
+      return false;
+    }
+  }
+
+  auto timestampLess = [](const InsRecord &a, const InsRecord &b) { return a.timestamp < b.timestamp; };
+  auto timestampEqual = [](const InsRecord &a, const InsRecord &b) { return a.timestamp == b.timestamp; };
+
+  // Chunks may be given in any order and may overlap each other
+  if (!is_sorted(out_records->begin(), out_records->end(), timestampLess))
+  {
+    stable_sort(out_records->begin(), out_records->end(), timestampLess);
+  }
+
+  out_records->erase(unique(out_records->begin(), out_records->end(), timestampEqual), out_records->end());
+
+  return true;
+}
+
+bool InsLoader::loadFile(const string &filepath, vector<InsRecord> *out_records)
+{
+  const size_t minChunkSize = 1 << 20; //Files smaller than this are not split [byte]
+
+  ifstream ifs(filepath.c_str(), ios::binary);
+
+  if (ifs.fail())
+  {
+    cout << "Failed to open file: " << filepath << endl;
+    return false;
+  }
+
+  ifs.seekg(0, ios::end);
+  string text(static_cast<size_t>(ifs.tellg()), '\0');
+  ifs.seekg(0, ios::beg);
+  ifs.read(&text[0], text.size());
+
+  // Ignore the header line
+  size_t bodyBegin = text.find('\n');
+  bodyBegin = (bodyBegin == string::npos) ? text.size() : bodyBegin + 1;
+
+  const char *begin = text.data() + bodyBegin;
+  const char *end = text.data() + text.size();
+
+  // Split into chunks at line boundaries
+  unsigned int threadNum = (_threadNum > 0) ? _threadNum : max(thread::hardware_concurrency(), 1u);
+  size_t bodySize = static_cast<size_t>(end - begin);
+  unsigned int chunkNum = static_cast<unsigned int>(min<size_t>(threadNum, bodySize / minChunkSize + 1));
+
+  vector<const char *> bounds(1, begin);
+  for (unsigned int i = 1; i < chunkNum; i++)
+  {
+    const char *p = max(begin + bodySize * i / chunkNum, bounds.back());
+    while (p < end && *p != '\n')
+    {
+      p++;
+    }
+
+    bounds.push_back(p < end ? p + 1 : end);
+  }
+  bounds.push_back(end);
+
+  // Parse chunks in parallel
+  vector<vector<InsRecord> > chunks(chunkNum);
+  vector<char> succeeded(chunkNum, 0);
+  vector<thread> workers;
+
+  for (unsigned int i = 1; i < chunkNum; i++)
+  {
+    workers.push_back(thread([&, i]() { succeeded.at(i) = parseLines(bounds.at(i), bounds.at(i + 1), &chunks.at(i)); }));
+  }
+
+  succeeded.at(0) = parseLines(bounds.at(0), bounds.at(1), &chunks.at(0));
+
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  if (find(succeeded.begin(), succeeded.end(), 0) != succeeded.end())
+  {
+    cout << "Wrong file format: " << filepath << endl;
+    return false;
+  }
+
+  // Stitch chunks
+  size_t recordNum = out_records->size();
+  for (const auto &chunk : chunks)
+  {
+    recordNum += chunk.size();
+  }
+
+  out_records->reserve(recordNum);
+  for (const auto &chunk : chunks)
+  {
+    out_records->insert(out_records->end(), chunk.begin(), chunk.end());
+  }
+
+  return true;
+}
+
+bool InsLoader::parseLines(const char *begin, const char *end, vector<InsRecord> *out_records)
+{
+  const int columnNum = 15;
+
+  const char *lineBegin = begin;
+
+  while (lineBegin < end)
+  {
+    const char *lineEnd = lineBegin;
+    while (lineEnd < end && *lineEnd != '\n')
+    {
+      lineEnd++;
+    }
+
+    const char *next = (lineEnd < end) ? lineEnd + 1 : end;
+
+    // Ignore empty lines
+    if (lineEnd == lineBegin || (lineEnd == lineBegin + 1 && *lineBegin == '\r'))
+    {
+      lineBegin = next;
+      continue;
+    }
+
+    InsRecord rec;
+    int col = 0;
+    const char *item = lineBegin;
+
+    while (item <= lineEnd)
+    {
+      const char *itemEnd = item;
+      while (itemEnd < lineEnd && *itemEnd != ',')
+      {
+        itemEnd++;
+      }
+
+      char *parsedEnd = nullptr;
+
+      if (col == 0)
+      {
+        rec.timestamp = strtoll(item, &parsedEnd, 10);
+      }
+      else if (col == 5)
+      {
+        rec.northing = strtod(item, &parsedEnd);
+      }
+      else if (col == 6)
+      {
+        rec.easting = strtod(item, &parsedEnd);
+      }
+
+      if (parsedEnd == item)
+      {
+        return false;
+      }
+
+      col++;
+      item = itemEnd + 1;
+    }
+
+    // Number of columns is wrong
+    if (col != columnNum)
+    {
+      return false;
+    }
+
+    out_records->push_back(rec);
+    lineBegin = next;
+  }
+
+  return true;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file InsLoader.hpp
+ * @author @jonatechout
+ * @brief Loads INS files (Oxford robotcar dataset) in parallel and aligns them on a common origin.
+ */
+#ifndef INSLOADER_H
+#define INSLOADER_H
+
+#include <string>
+#include <vector>
+#include "Car.hpp"
+
+/**
+ * @class InsLoader
+ * @brief Loads INS files (Oxford robotcar dataset) in parallel and aligns them on a common origin.
+ * A drive may be split into several files (chunks), which are merged into one timeline.
+ * Several drives can be loaded at once; the earliest sample of all the drives becomes
+ * the origin of time and XY position.
+ */
+class InsLoader
+{
+public:
+  InsLoader();
+  virtual ~InsLoader();
+
+  /**
+   * @brief Set the number of threads to parse a file.
+   *
+   * @param threadNum Number of threads (0: number of hardware threads)
+   */
+  void setThreadNum(unsigned int threadNum);
+
+  /**
+   * @brief Load several drives and align them on a common origin.
+   *
+   * @param drives List of drives, each is a list of INS file paths
+   * @param out_drives Position data of each drive
+   * @return true  Data load has succeeded.
+   * @return false  Data load failed.
+   */
+  bool load(const std::vector<std::vector<std::string> > &drives,
+            std::vector<std::vector<Car::PositionData> > *out_drives);
+
+  /**
+   * @brief Load a drive. The first sample becomes the origin.
+   *
+   * @param files List of INS file paths of the drive
+   * @param out_data Position data
+   * @return true  Data load has succeeded.
+   * @return false  Data load failed.
+   */
+  bool load(const std::vector<std::string> &files, std::vector<Car::PositionData> *out_data);
+
+protected:
+  struct InsRecord
+  {
+    long long timestamp; ///< Timestamp [usec]
+    double northing;     ///< Northing [m]
+    double easting;      ///< Easting [m]
+  };
+
+  /**
+   * @brief Load all the files of a drive, sorted by timestamp.
+   *
+   * @param files List of INS file paths
+   * @param out_records Loaded records
+   * @return true  Data load has succeeded.
+   * @return false  Data load failed.
+   */
+  bool loadDrive(const std::vector<std::string> &files, std::vector<InsRecord> *out_records);
+
+  /**
+   * @brief Load a file, splitting it into chunks parsed by threads.
+   *
+   * @param filepath
+   * @param out_records Loaded records (appended)
+   * @return true  Data load has succeeded.
+   * @return false  Data load failed.
+   */
+  bool loadFile(const std::string &filepath, std::vector<InsRecord> *out_records);
+
+  /**
+   * @brief Parse lines of CSV text.
+   *
+   * @param begin Beginning of the first line
+   * @param end End of the last line
+   * @param out_records Parsed records
+   * @return true  Parse has succeeded.
+   * @return false  Wrong format.
+   */
+  static bool parseLines(const char *begin, const char *end, std::vector<InsRecord> *out_records);
+
+  unsigned int _threadNum; ///< Number of threads to parse a file (0: number of hardware threads)
+};
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file MathKernel.hpp
+ * @author @jonatechout
+ * @brief Trigonometric functions used in vehicle kinematics.
+ *
+ * By default these call libm. If PLATOON_FAST_MATH is defined (make FAST_MATH=1), branch-light polynomial
+ * approximations are used instead, which the compiler can inline and vectorize.
+ * Absolute error of the approximations:
+ * - sinCos: < 2e-9 for |angle| < 1e5 rad
+ * - atan2:  < 3e-9 rad
+ * - tan:    < 1e-8 relative, for |angle| < 1.2 rad (tyre angle range)
+ * make accuracy compares the trajectories of a scenario run with both kernels (tools/kernel_accuracy.cpp).
+ */
+#ifndef MATHKERNEL_H
+#define MATHKERNEL_H
+
+#include <math.h>
+
+namespace MathKernel
+{
+#ifdef PLATOON_FAST_MATH
+
+/**
+ * @brief Calculate sine and cosine of the same angle at once.
+ *
+ * @param angle [rad]
+ * @param outSin sin(angle)
+ * @param outCos cos(angle)
+ */
+inline void sinCos(double angle, double *outSin, double *outCos)
+{
+  const double twoOverPi = 0.63661977236758134308;
+  const double piOver2Hi = 1.57079632673412561417; // pi/2 split into two parts for accurate reduction
+  const double piOver2Lo = 6.07710050650619224932e-11;
+
+  // Reduce to r in [-pi/4, pi/4], angle = r + quadrant * pi/2
+  double k = floor(angle * twoOverPi + 0.5);
+  double r = (angle - k * piOver2Hi) - k * piOver2Lo;
+  long quadrant = static_cast<long>(k) & 3;
+
+  // Taylor series up to r^9 (sin) and r^10 (cos)
+  double r2 = r * r;
+  double s = r + r * r2 * (-1.0 / 6.0 + r2 * (1.0 / 120.0 + r2 * (-1.0 / 5040.0 + r2 * (1.0 / 362880.0))));
+  double c = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24.0 + r2 * (-1.0 / 720.0 + r2 * (1.0 / 40320.0 + r2 * (-1.0 / 3628800.0)))));
+
+  double sinR = (quadrant & 1) ? c : s;
+  double cosR = (quadrant & 1) ? s : c;
+
+  *outSin = (quadrant & 2) ? -sinR : sinR;
+  *outCos = ((quadrant + 1) & 2) ? -cosR : cosR;
+}
+
+/**
+ * @brief Arc tangent of y/x using the signs of both arguments. atan2(0, 0) returns 0.
+ *
+ * @param y
+ * @param x
+ * @return double Angle [rad] in [-pi, pi]
+ */
+inline double atan2(double y, double x)
+{
+  const double tanPiOver8 = 0.41421356237309504880;
+
+  double ax = fabs(x);
+  double ay = fabs(y);
+  double maxValue = (ax > ay) ? ax : ay;
+  double minValue = (ax > ay) ? ay : ax;
+
+  if (maxValue == 0.0)
+  {
+    return 0.0;
+  }
+
+  // Reduce to u in [-tan(pi/8), tan(pi/8)]
+  double t = minValue / maxValue;
+  bool shifted = t > tanPiOver8;
+  double u = shifted ? (t - 1.0) / (t + 1.0) : t;
+
+  // Taylor series up to u^17
+  double u2 = u * u;
+  double a = u * (1.0 + u2 * (-1.0 / 3.0 + u2 * (1.0 / 5.0 + u2 * (-1.0 / 7.0 + u2 * (1.0 / 9.0 +
+             u2 * (-1.0 / 11.0 + u2 * (1.0 / 13.0 + u2 * (-1.0 / 15.0 + u2 * (1.0 / 17.0)))))))));
+
+  a = shifted ? a + M_PI_4 : a;
+  a = (ay > ax) ? M_PI_2 - a : a;
+  a = (x < 0.0) ? M_PI - a : a;
+
+  return (y < 0.0) ? -a : a;
+}
+
+/**
+ * @brief Tangent
+ *
+ * @param angle [rad]
+ * @return double tan(angle)
+ */
+inline double tan(double angle)
+{
+  double s, c;
+  sinCos(angle, &s, &c);
+
+  return s / c;
+}
+
+#else
+
+inline void sinCos(double angle, double *outSin, double *outCos)
+{
+  *outSin = ::sin(angle);
+  *outCos = ::cos(angle);
+}
+
+inline double atan2(double y, double x)
+{
+  return ::atan2(y, x);
+}
+
+inline double tan(double angle)
+{
+  return ::tan(angle);
+}
+
+#endif
+}
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file MemoryReport.cpp
+ * @author @jonatechout
+ * @brief Memory footprint of each subsystem, in total and per vehicle.
+ */
+#include "MemoryReport.hpp"
+#include <iomanip>
+
+using namespace std;
+
+MemoryReport::MemoryReport() : _entries()
+{
+}
+
+MemoryReport::~MemoryReport()
+{
+}
+
+void MemoryReport::add(const string &name, size_t bytes, unsigned int count)
+{
+  for (auto &entry : _entries)
+  {
+    if (entry.name == name)
+    {
+      entry.bytes += bytes;
+      entry.count += count;
+      return;
+    }
+  }
+
+  Entry entry;
+  entry.name = name;
+  entry.bytes = bytes;
+  entry.count = count;
+  _entries.push_back(entry);
+}
+
+void MemoryReport::clear()
+{
+  _entries.clear();
+}
+
+size_t MemoryReport::total() const
+{
+  size_t bytes = 0;
+  for (const auto &entry : _entries)
+  {
+    bytes += entry.bytes;
+  }
+
+  return bytes;
+}
+
+void MemoryReport::print(ostream &os, unsigned int vehicleNum) const
+{
+  const double kib = 1024.0;
+
+  ios::fmtflags flags = os.flags();
+  os << fixed << setprecision(1);
+
+  os << "Memory usage [KiB]" << endl;
+  for (const auto &entry : _entries)
+  {
+    os << "  " << left << setw(16) << entry.name << right << setw(12) << entry.bytes / kib
+       << "  (" << entry.count << " x " << ((entry.count > 0) ? entry.bytes / kib / entry.count : 0.0) << ")" << endl;
+  }
+
+  os << "  " << left << setw(16) << "total" << right << setw(12) << total() / kib;
+  if (vehicleNum > 0)
+  {
+    os << "  (" << vehicleNum << " vehicles, " << total() / kib / vehicleNum << " per vehicle)";
+  }
+  os << endl;
+
+  os.flags(flags);
+}
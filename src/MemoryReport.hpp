@@ -0,0 +1,62 @@
+/**
+ * @file MemoryReport.hpp
+ * @author @jonatechout
+ * @brief Memory footprint of each subsystem, in total and per vehicle.
+ */
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <stddef.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class MemoryReport
+ * @brief Memory footprint of each subsystem, in total and per vehicle.
+ * Subsystems count their own bytes (memoryUsage() of each class): capacity of containers and heap blocks they own,
+ * plus the size of objects which are allocated one by one. Allocator overhead is not counted.
+ */
+class MemoryReport
+{
+public:
+  struct Entry
+  {
+    std::string name;    ///< Subsystem
+    size_t bytes;        ///< Bytes of all the objects
+    unsigned int count;  ///< Number of objects
+  };
+
+  MemoryReport();
+  virtual ~MemoryReport();
+
+  /**
+   * @brief Add bytes of an object to a subsystem.
+   *
+   * @param name Subsystem
+   * @param bytes
+   * @param count Number of objects
+   */
+  void add(const std::string &name, size_t bytes, unsigned int count = 1);
+
+  /**
+   * @brief Remove all the entries.
+   */
+  void clear();
+
+  /**
+   * @brief Print bytes of each subsystem, total and per vehicle.
+   *
+   * @param os
+   * @param vehicleNum Number of vehicles to divide the total
+   */
+  void print(std::ostream &os, unsigned int vehicleNum) const;
+
+  size_t total() const;
+  const std::vector<Entry> &entries() const { return _entries; }
+
+protected:
+  std::vector<Entry> _entries; ///< Subsystems in order of addition
+};
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * @file PathHistory.cpp
+ * @author @jonatechout
+ * @brief Polyline path with cumulative arc-length for each point.
+ */
+#include "PathHistory.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+bool arcLengthLess(double s, const PathHistory::PathPoint &point)
+{
+  return s < point.s;
+}
+}
+
+PathHistory::PathHistory() : _points(),
+                             _maxSize(100)
+{
+}
+
+PathHistory::~PathHistory()
+{
+}
+
+void PathHistory::setMaxSize(unsigned int maxSize)
+{
+  _maxSize = max(maxSize, 1u);
+
+  while (_points.size() > _maxSize)
+  {
+    _points.pop_front();
+  }
+}
+
+void PathHistory::clear()
+{
+  _points.clear();
+}
+
+void PathHistory::push(const Car::PositionData &point)
+{
+  PathPoint p;
+  p.timestamp = point.timestamp;
+  p.x = point.x;
+  p.y = point.y;
+  p.s = 0.0;
+
+  if (!_points.empty())
+  {
+    const PathPoint &last = _points.back();
+    p.s = last.s + sqrt((p.x - last.x) * (p.x - last.x) + (p.y - last.y) * (p.y - last.y));
+  }
+
+  _points.push_back(p);
+
+  if (_points.size() > _maxSize)
+  {
+    _points.pop_front();
+  }
+}
+
+void PathHistory::truncate(double s)
+{
+  if (_points.empty() || s >= _points.back().s)
+  {
+    return;
+  }
+
+  // New end point is interpolated, so the part before s keeps its shape
+  Car::PositionData end = pointAt(s);
+
+  PathPoint p;
+  p.timestamp = end.timestamp;
+  p.x = end.x;
+  p.y = end.y;
+  p.s = max(s, _points.front().s);
+
+  while (!_points.empty() && _points.back().s >= p.s)
+  {
+    _points.pop_back();
+  }
+
+  _points.push_back(p);
+}
+
+double PathHistory::project(double x, double y, double *hint) const
+{
+  if (_points.empty())
+  {
+    return 0.0;
+  }
+
+  unsigned int closest = 0;
+
+  if (hint != nullptr && *hint >= 0.0)
+  {
+    // Start from the hint and descend to the local minimum of distance
+    closest = findSegment(*hint);
+
+    while (closest + 1 < _points.size() && distanceSq(x, y, closest + 1) < distanceSq(x, y, closest))
+    {
+      closest++;
+    }
+
+    while (closest > 0 && distanceSq(x, y, closest - 1) < distanceSq(x, y, closest))
+    {
+      closest--;
+    }
+  }
+  else
+  {
+    // Search all the points
+    double minDistSq = distanceSq(x, y, 0);
+    for (unsigned int i = 1; i < _points.size(); i++)
+    {
+      double distSq = distanceSq(x, y, i);
+      if (distSq < minDistSq)
+      {
+        closest = i;
+        minDistSq = distSq;
+      }
+    }
+  }
+
+  double bestS = _points.at(closest).s;
+  double bestDistSq = distanceSq(x, y, closest);
+
+  // Project onto the segments on both sides of the closest point
+  unsigned int firstSegment = (closest > 0) ? closest - 1 : 0;
+  for (unsigned int i = firstSegment; i <= closest && i + 1 < _points.size(); i++)
+  {
+    const PathPoint &a = _points.at(i);
+    const PathPoint &b = _points.at(i + 1);
+
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double lengthSq = dx * dx + dy * dy;
+
+    if (lengthSq <= 0.0)
+    {
+      continue;
+    }
+
+    double t = ((x - a.x) * dx + (y - a.y) * dy) / lengthSq;
+    t = min(max(t, 0.0), 1.0);
+
+    double px = a.x + dx * t - x;
+    double py = a.y + dy * t - y;
+    double distSq = px * px + py * py;
+
+    if (distSq < bestDistSq)
+    {
+      bestDistSq = distSq;
+      bestS = a.s + (b.s - a.s) * t;
+    }
+  }
+
+  if (hint != nullptr)
+  {
+    *hint = bestS;
+  }
+
+  return bestS;
+}
+
+Car::PositionData PathHistory::pointAt(double s) const
+{
+  Car::PositionData point;
+  point.timestamp = 0.0;
+  point.x = 0.0;
+  point.y = 0.0;
+
+  if (_points.empty())
+  {
+    return point;
+  }
+
+  unsigned int i = findSegment(s);
+  const PathPoint &a = _points.at(i);
+
+  if (i + 1 >= _points.size())
+  {
+    point.timestamp = a.timestamp;
+    point.x = a.x;
+    point.y = a.y;
+
+    return point;
+  }
+
+  const PathPoint &b = _points.at(i + 1);
+
+  double t = (b.s > a.s) ? (s - a.s) / (b.s - a.s) : 0.0;
+  t = min(max(t, 0.0), 1.0);
+
+  point.timestamp = a.timestamp + (b.timestamp - a.timestamp) * t;
+  point.x = a.x + (b.x - a.x) * t;
+  point.y = a.y + (b.y - a.y) * t;
+
+  return point;
+}
+
+void PathHistory::directionAt(double s, double *out_cos, double *out_sin) const
+{
+  *out_cos = 1.0;
+  *out_sin = 0.0;
+
+  if (_points.size() < 2)
+  {
+    return;
+  }
+
+  unsigned int i = findSegment(s);
+  const PathPoint &a = _points.at(i);
+  const PathPoint &b = _points.at(i + 1);
+
+  double length = b.s - a.s;
+  if (length > 0.0)
+  {
+    *out_cos = (b.x - a.x) / length;
+    *out_sin = (b.y - a.y) / length;
+  }
+}
+
+size_t PathHistory::memoryUsage() const
+{
+  const size_t blockSize = 512; //Size of a block of std::deque (libstdc++) [bytes]
+  const size_t pointsPerBlock = max(blockSize / sizeof(PathPoint), static_cast<size_t>(1));
+
+  // A deque has one more block than needed at the back
+  size_t blockNum = _points.size() / pointsPerBlock + 1;
+
+  return blockNum * pointsPerBlock * sizeof(PathPoint);
+}
+
+unsigned int PathHistory::findSegment(double s) const
+{
+  if (_points.size() < 2)
+  {
+    return 0;
+  }
+
+  // First point whose arc-length is larger than s
+  deque<PathPoint>::const_iterator it = upper_bound(_points.begin(), _points.end(), s, arcLengthLess);
+
+  if (it == _points.begin())
+  {
+    return 0;
+  }
+
+  unsigned int index = static_cast<unsigned int>(it - _points.begin()) - 1;
+
+  return min(index, static_cast<unsigned int>(_points.size()) - 2);
+}
+
+double PathHistory::distanceSq(double x, double y, unsigned int index) const
+{
+  const PathPoint &p = _points.at(index);
+
+  return (p.x - x) * (p.x - x) + (p.y - y) * (p.y - y);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file PathHistory.hpp
+ * @author @jonatechout
+ * @brief Polyline path with cumulative arc-length for each point.
+ */
+#ifndef PATHHISTORY_H
+#define PATHHISTORY_H
+
+#include <deque>
+#include "Car.hpp"
+
+/**
+ * @class PathHistory
+ * @brief Polyline path with cumulative arc-length for each point.
+ * Points are appended at the back and dropped from the front. Arc-length keeps counting from the first point
+ * ever pushed, so an arc-length obtained before dropping points stays valid.
+ */
+class PathHistory
+{
+public:
+  struct PathPoint
+  {
+    double timestamp; ///< Time the point was recorded [s]
+    double x;         ///< X [m] (world coordinate)
+    double y;         ///< Y [m] (world coordinate)
+    double s;         ///< Arc-length from the first point ever pushed [m]
+  };
+
+  PathHistory();
+  virtual ~PathHistory();
+
+  /**
+   * @brief Set the maximum number of points. Oldest points are dropped when exceeded.
+   *
+   * @param maxSize
+   */
+  void setMaxSize(unsigned int maxSize);
+
+  /**
+   * @brief Remove all the points.
+   */
+  void clear();
+
+  /**
+   * @brief Append a point at the end of the path.
+   *
+   * @param point
+   */
+  void push(const Car::PositionData &point);
+
+  /**
+   * @brief Remove the part of the path beyond given arc-length. Arc-length of remaining points is kept.
+   * Only the removed points are visited.
+   *
+   * @param s Arc-length of the new end point [m]
+   */
+  void truncate(double s);
+
+  /**
+   * @brief Get the arc-length of the closest point on the path.
+   *
+   * @param x X [m] (world coordinate)
+   * @param y Y [m] (world coordinate)
+   * @param hint Arc-length to start searching from, updated with the result.
+   *             Whole path is searched if nullptr or negative.
+   * @return double Arc-length [m]
+   */
+  double project(double x, double y, double *hint) const;
+
+  /**
+   * @brief Get the point at given arc-length. Linearly interpolated between points and clamped at both ends.
+   *
+   * @param s Arc-length [m]
+   * @return Car::PositionData Point on the path
+   */
+  Car::PositionData pointAt(double s) const;
+
+  /**
+   * @brief Get the direction of the segment which contains given arc-length.
+   *
+   * @param s Arc-length [m]
+   * @param out_cos Cosine of the direction (1 if the path has no length)
+   * @param out_sin Sine of the direction
+   */
+  void directionAt(double s, double *out_cos, double *out_sin) const;
+
+  /**
+   * @brief Returns bytes of the points, in blocks of 512 bytes as std::deque of libstdc++ allocates.
+   */
+  size_t memoryUsage() const;
+
+  bool empty() const { return _points.empty(); }
+  unsigned int size() const { return _points.size(); }
+  const PathPoint &front() const { return _points.front(); }
+  const PathPoint &back() const { return _points.back(); }
+
+protected:
+  /**
+   * @brief Get the index of the segment which contains given arc-length. (Binary search)
+   *
+   * @param s Arc-length [m]
+   * @return unsigned int Index of the first point of the segment
+   */
+  unsigned int findSegment(double s) const;
+
+  /**
+   * @brief Squared distance between given point and the point at index
+   */
+  double distanceSq(double x, double y, unsigned int index) const;
+
+  std::deque<PathPoint> _points; ///< Points of the path
+  unsigned int _maxSize;         ///< Maximum number of points
+};
+
+#endif
@@ -7,9 +7,24 @@
 using namespace std;
 using namespace cv;
 
+namespace
+{
+const double restVelocity = 0.05; //Velocity regarded as stopped [m/s]
+const double restDistance = 0.02; //Movement of data regarded as stopped, the lag of a sleeping car at restart [m]
+const double rebaseDistance = 500.0; //Distance from the local origin of Kalman filter to move it [m] (float has 0.1 mm steps)
+const long long maxReplayTicks = 500; //Ticks skipped while sleeping which are filtered at wake-up
+}
+
 PlaybackCar::PlaybackCar() : _dataIndex(0),
+                             _nextMoveIndex(0),
                              _kalman(4, 2),
-                             _kalmanStateIsInit(false)
+                             _processNoise(0.1),
+                             _measurementNoise(0.5),
+                             _kalmanStateIsInit(false),
+                             _kalmanOriginX(0.0),
+                             _kalmanOriginY(0.0),
+                             _lastUpdateTime(0.0),
+                             _prevVelocity(0.0)
 {
 }
 
@@ -26,30 +41,67 @@ void PlaybackCar::update()
 
   _currentTime += _periodTime;
 
+  // Ticks skipped while sleeping (EventScheduler) are filtered now, so the state and covariance are the same
+  // as when updated every tick. Measurements did not move while sleeping, so the filter settles within the
+  // last ticks and older ones are not replayed.
+  long long skippedTicks = static_cast<long long>(floor((_currentTime - _lastUpdateTime) / _periodTime + 0.5)) - 1;
+  _lastUpdateTime = _currentTime;
+
+  if (_kalmanStateIsInit)
+  {
+    for (long long tick = max(skippedTicks - maxReplayTicks, 0LL); tick < skippedTicks; tick++)
+    {
+      filterStep(_currentTime - (skippedTicks - tick) * _periodTime);
+    }
+  }
+
+  _prevVelocity = _velocity;
+  filterStep(_currentTime);
+
+  // While stopped, find the next data which moves from the current one.
+  if (_velocity < restVelocity && _nextMoveIndex <= _dataIndex)
+  {
+    const PositionData &current = _data.at(_dataIndex);
+
+    _nextMoveIndex = _dataIndex + 1;
+    while (_nextMoveIndex < _data.size() &&
+           (_data.at(_nextMoveIndex).x - current.x) * (_data.at(_nextMoveIndex).x - current.x) +
+           (_data.at(_nextMoveIndex).y - current.y) * (_data.at(_nextMoveIndex).y - current.y) <= restDistance * restDistance)
+    {
+      _nextMoveIndex++;
+    }
+  }
+}
+
+void PlaybackCar::filterStep(double time)
+{
   // If next data time is already passed, search for the latest data.
-  if (_data.at(_dataIndex + 1).timestamp <= _currentTime)
+  if (_dataIndex < _data.size() - 1 && _data.at(_dataIndex + 1).timestamp <= time)
   {
-    while (_dataIndex < _data.size() - 1 && _data.at(_dataIndex + 1).timestamp <= _currentTime)
+    while (_dataIndex < _data.size() - 1 && _data.at(_dataIndex + 1).timestamp <= time)
     {
       _dataIndex++;
     }
 
-    // Kalman filter measurement
-    Mat measurement = Mat::zeros(2, 1, CV_32F);
-    measurement.at<float>(0) = _data.at(_dataIndex).x;
-    measurement.at<float>(1) = _data.at(_dataIndex).y;
-
-    // If Kalman filter pre-state is not initialized, put the current measurement.
+    // If Kalman filter pre-state is not initialized, start from the current measurement as the local origin.
     if (!_kalmanStateIsInit)
     {
-      _kalman.statePre.at<float>(0) = measurement.at<float>(0);
-      _kalman.statePre.at<float>(1) = measurement.at<float>(1);
+      _kalmanOriginX = _data.at(_dataIndex).x;
+      _kalmanOriginY = _data.at(_dataIndex).y;
+
+      _kalman.statePre.at<float>(0) = 0.0;
+      _kalman.statePre.at<float>(1) = 0.0;
       _kalman.statePre.at<float>(2) = 0.0;
       _kalman.statePre.at<float>(3) = 0.0;
 
       _kalmanStateIsInit = true;
     }
 
+    // Kalman filter measurement (relative to the local origin)
+    Mat measurement = Mat::zeros(2, 1, CV_32F);
+    measurement.at<float>(0) = _data.at(_dataIndex).x - _kalmanOriginX;
+    measurement.at<float>(1) = _data.at(_dataIndex).y - _kalmanOriginY;
+
     // Kalman filter update measurement
     _kalman.correct(measurement);
   }
@@ -60,8 +112,8 @@ void PlaybackCar::update()
     Mat estimatedState = _kalman.predict();
 
     // Update state using predicted state
-    _x = estimatedState.at<float>(0);
-    _y = estimatedState.at<float>(1);
+    _x = _kalmanOriginX + estimatedState.at<float>(0);
+    _y = _kalmanOriginY + estimatedState.at<float>(1);
 
     double vx = estimatedState.at<float>(2);
     double vy = estimatedState.at<float>(3);
@@ -72,88 +124,63 @@ void PlaybackCar::update()
     if (_velocity > 0.5)
     {
       // Assuming moving angle matches heading anble. (This is not strictly correct, but good enough for low speed.)
-      _heading = atan2(vy, vx);
+      _heading = MathKernel::atan2(vy, vx);
+    }
+
+    if (fabs(estimatedState.at<float>(0)) > rebaseDistance || fabs(estimatedState.at<float>(1)) > rebaseDistance)
+    {
+      rebaseKalman();
     }
   }
 }
 
-bool PlaybackCar::setData(string filepath)
+bool PlaybackCar::canSleep() const
 {
-  _data.clear();
-
-  ifstream ifs(filepath.c_str());
+  const double sleepVelocity = 0.01; //Velocity to sleep, lower than restVelocity [m/s]
 
-  if (ifs.fail())
+  if (_data.size() == 0 || _dataIndex >= _data.size() - 1)
   {
-    cout << "Failed to open file: " << filepath << endl;
-    return false;
+    // No data left to play
+    return true;
   }
 
-  string line;
-  getline(ifs, line); // Ignore the header line
+  if (!_kalmanStateIsInit)
+  {
+    // Waiting for the first measurement
+    return true;
+  }
 
-  long firstTimestamp = 0;
-  double firstX = 0.0;
-  double firstY = 0.0;
+  // The estimate still moves (slowing down or starting) until the filter has settled on the stopped position
+  return _velocity < sleepVelocity && _velocity <= _prevVelocity && _nextMoveIndex > _dataIndex;
+}
 
-  // Parse CSV file
-  while (getline(ifs, line))
+double PlaybackCar::wakeUpTime() const
+{
+  if (_data.size() == 0 || _dataIndex >= _data.size() - 1)
   {
-    std::string item;
-    std::istringstream linestream(line);
-
-    int col = 0;
-    PositionData recdata;
+    return -1.0;
+  }
 
-    while (getline(linestream, item, ','))
-    {
-      if (col == 0)
-      {
-        if (_data.empty())
-        {
-          firstTimestamp = stol(item); //First data
-        }
-
-        long timestamp = stol(item);
-
-        //Calculate time difference from first timestamp
-        recdata.timestamp = static_cast<double>(timestamp - firstTimestamp) * 1e-6; //[sec]
-      }
-      else if (col == 5)
-      {
-        if (_data.empty())
-        {
-          firstY = stod(item); // First data
-        }
-
-        recdata.y = stod(item) - firstY; //Northing
-      }
-      else if (col == 6)
-      {
-        if (_data.empty())
-        {
-          firstX = stod(item); // First data
-        }
-
-        recdata.x = stod(item) - firstX; //Easting
-      }
-
-      col++;
-    }
+  if (!_kalmanStateIsInit)
+  {
+    return _data.at(_dataIndex + 1).timestamp;
+  }
 
-    // Number of columns is wrong
-    if (col != 15)
-    {
-      cout << "Wrong file format: " << filepath << endl;
-      _data.clear();
+  return (_nextMoveIndex < _data.size()) ? _data.at(_nextMoveIndex).timestamp : -1.0;
+}
 
-      return false;
-    }
+bool PlaybackCar::setData(string filepath)
+{
+  InsLoader loader;
 
-    _data.push_back(recdata);
-  }
+  return loader.load(vector<string>(1, filepath), &_data);
+}
 
-  return true;
+void PlaybackCar::setData(const vector<PositionData> &data)
+{
+  _data = data;
+  _dataIndex = 0;
+  _nextMoveIndex = 0;
 }
 
 void PlaybackCar::getWholePath(vector<PositionData> *out_path, double interval)
@@ -185,9 +212,17 @@ void PlaybackCar::getWholePath(vector<PositionData> *out_path, double interval)
   }
 }
 
+void PlaybackCar::setKalmanNoise(double processNoise, double measurementNoise)
+{
+  _processNoise = processNoise;
+  _measurementNoise = measurementNoise;
+}
+
 void PlaybackCar::initKalman()
 {
   _kalmanStateIsInit = false;
+  _kalmanOriginX = 0.0;
+  _kalmanOriginY = 0.0;
 
   _kalman.transitionMatrix =
     (Mat_<float>(4, 4) <<
@@ -197,7 +232,42 @@ void PlaybackCar::initKalman()
       0,      0,      0,            1);
 
   setIdentity(_kalman.measurementMatrix);
-  setIdentity(_kalman.processNoiseCov, Scalar::all(_periodTime * 0.1));
-  setIdentity(_kalman.measurementNoiseCov, Scalar::all(0.5));
+  setIdentity(_kalman.processNoiseCov, Scalar::all(_periodTime * _processNoise));
+  setIdentity(_kalman.measurementNoiseCov, Scalar::all(_measurementNoise));
   setIdentity(_kalman.errorCovPost, Scalar::all(0.1));
-}
\ No newline at end of file
+
+  _lastUpdateTime = _currentTime;
+}
+
+void PlaybackCar::rebaseKalman()
+{
+  // The shift is a float, so the origin (double) moves exactly by the amount removed from the state
+  float shiftX = _kalman.statePost.at<float>(0);
+  float shiftY = _kalman.statePost.at<float>(1);
+
+  _kalmanOriginX += shiftX;
+  _kalmanOriginY += shiftY;
+
+  _kalman.statePost.at<float>(0) -= shiftX;
+  _kalman.statePost.at<float>(1) -= shiftY;
+  _kalman.statePre.at<float>(0) -= shiftX;
+  _kalman.statePre.at<float>(1) -= shiftY;
+}
+
+size_t PlaybackCar::kalmanMemoryUsage() const
+{
+  const Mat *matrices[] = {
+    &_kalman.statePre, &_kalman.statePost, &_kalman.transitionMatrix, &_kalman.controlMatrix,
+    &_kalman.measurementMatrix, &_kalman.processNoiseCov, &_kalman.measurementNoiseCov,
+    &_kalman.errorCovPre, &_kalman.gain, &_kalman.errorCovPost,
+    &_kalman.temp1, &_kalman.temp2, &_kalman.temp3, &_kalman.temp4, &_kalman.temp5
+  };
+
+  size_t bytes = 0;
+  for (const Mat *matrix : matrices)
+  {
+    bytes += matrix->total() * matrix->elemSize();
+  }
+
+  return bytes;
+}
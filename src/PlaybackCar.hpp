@@ -14,12 +14,15 @@
 #include <sstream>
 #include <opencv2/video/tracking.hpp>
 #include "Car.hpp"
+#include "MathKernel.hpp"
+#include "InsLoader.hpp"
 
 /**
  * @class PlaybackCar
  * @brief This class can load XY data from given data file (Oxford robotcar dataset).
  * Applies Kalman filter to it and estimates XY, velocity and heading angle.
  * First data point becomes the origin point of XY position, so the initial position of car is always (0,0).
+ * Kalman filter works on float, so its positions are relative to a local origin which follows the car.
  */
 class PlaybackCar : public Car
 {
@@ -32,6 +35,16 @@ public:
    */
   virtual void update();
 
+  /**
+   * @brief Returns true while the car is stopped (not speeding up) and the data does not move, or no data is left to play.
+   */
+  virtual bool canSleep() const;
+
+  /**
+   * @brief Returns the timestamp of the next measurement which moves the car.
+   */
+  virtual double wakeUpTime() const;
+
   /**
    * @brief Set the Data file path and load data.
    *
@@ -41,6 +54,13 @@ public:
    */
   bool setData(std::string filepath);
 
+  /**
+   * @brief Set the position data already loaded (e.g. by InsLoader).
+   *
+   * @param data Position data sorted by timestamp
+   */
+  void setData(const std::vector<PositionData> &data);
+
   /**
    * @brief Get the Whole Path
    *
@@ -49,19 +69,59 @@ public:
    */
   void getWholePath(std::vector<PositionData>* out_path, double interval);
 
+  /**
+   * @brief Set the noise covariances of Kalman filter. Must be called before initKalman().
+   *
+   * @param processNoise Process noise per second
+   * @param measurementNoise Measurement noise [m^2]
+   */
+  void setKalmanNoise(double processNoise, double measurementNoise);
+
   /**
    * @brief Initialize Kalman filter.
    *
    */
   void initKalman();
 
+  virtual size_t objectSize() const { return sizeof(*this); }
+
+  /**
+   * @brief Returns bytes of loaded position data.
+   */
+  size_t dataMemoryUsage() const { return _data.capacity() * sizeof(PositionData); }
+
+  /**
+   * @brief Returns bytes of Kalman filter matrices.
+   */
+  size_t kalmanMemoryUsage() const;
+
 protected:
+  /**
+   * @brief Apply the measurements which have arrived by given time and predict one period.
+   *
+   * @param time Simulation time at the end of the period [s]
+   */
+  void filterStep(double time);
+
+  /**
+   * @brief Move the local origin of Kalman filter to the estimated position.
+   * Only positions are shifted, velocities and covariances do not depend on the origin.
+   */
+  void rebaseKalman();
+
   std::vector<PositionData> _data;  ///< Loaded position data
   unsigned int _dataIndex;          ///< Index of playing data
+  unsigned int _nextMoveIndex;      ///< Index of the first data which moves from _dataIndex (while stopped)
 
   cv::KalmanFilter _kalman; ///< Kalman filter
+  double _processNoise;     ///< Process noise of Kalman filter per second
+  double _measurementNoise; ///< Measurement noise of Kalman filter [m^2]
 
   bool _kalmanStateIsInit; ///< True if Kalman filter's pre-state is initialized.
+  double _kalmanOriginX;   ///< X of the local origin of Kalman filter [m] (world coordinate)
+  double _kalmanOriginY;   ///< Y of the local origin of Kalman filter [m] (world coordinate)
+  double _lastUpdateTime;  ///< Simulation time at last update [s]
+  double _prevVelocity;    ///< Velocity before last update [m/s]
 };
 
 #endif
\ No newline at end of file
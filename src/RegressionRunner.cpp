@@ -0,0 +1,231 @@
+/**
+ * @file RegressionRunner.cpp
+ * @author @jonatechout
+ * @brief Runs a directory of scenarios without visualization and compares their metrics with baselines.
+ */
+#include "RegressionRunner.hpp"
+#include <dirent.h>
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "ConfigFile.hpp"
+
+using namespace std;
+
+RegressionRunner::RegressionRunner() : _threadNum(0),
+                                       _behaviorTolerance(0.01),
+                                       _performanceTolerance(0.5),
+                                       _memoryTolerance(0.1)
+{
+}
+
+RegressionRunner::~RegressionRunner()
+{
+}
+
+void RegressionRunner::setThreadNum(unsigned int threadNum)
+{
+  _threadNum = threadNum;
+}
+
+void RegressionRunner::setTolerance(double behaviorTolerance, double performanceTolerance, double memoryTolerance)
+{
+  _behaviorTolerance = behaviorTolerance;
+  _performanceTolerance = performanceTolerance;
+  _memoryTolerance = memoryTolerance;
+}
+
+bool RegressionRunner::run(const string &directory, bool updateBaseline)
+{
+  _results.clear();
+
+  vector<string> files;
+  if (!listScenarios(directory, &files))
+  {
+    return false;
+  }
+
+  if (files.empty())
+  {
+    cout << "No scenario file (*.scn) in " << directory << endl;
+    return false;
+  }
+
+  _results.resize(files.size());
+
+  // Scenarios are independent, each worker takes the next one
+  unsigned int threadNum = (_threadNum > 0) ? _threadNum : max(thread::hardware_concurrency(), 1u);
+  threadNum = max(min(threadNum, static_cast<unsigned int>(files.size())), 1u);
+
+  atomic<unsigned int> nextScenario(0);
+
+  auto work = [&]() {
+    unsigned int index;
+    while ((index = nextScenario.fetch_add(1)) < files.size())
+    {
+      runScenario(files.at(index), updateBaseline, &_results.at(index));
+    }
+  };
+
+  vector<thread> workers;
+  for (unsigned int i = 1; i < threadNum; i++)
+  {
+    workers.push_back(thread(work));
+  }
+
+  work();
+
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  // Print in the order of file names
+  const char *statusNames[] = {"PASS", "FAIL", "SLOW", "MEMORY", "NEW", "ERROR"};
+  bool passed = true;
+  for (const auto &result : _results)
+  {
+    cout << statusNames[result.status] << "  " << result.scenarioFile << result.message << endl;
+
+    if (result.status == FAIL || result.status == SLOW || result.status == MEMORY ||
+        result.status == ERROR || (result.status == NEW && !updateBaseline))
+    {
+      passed = false;
+    }
+  }
+
+  return passed;
+}
+
+bool RegressionRunner::listScenarios(const string &directory, vector<string> *out_files)
+{
+  out_files->clear();
+
+  DIR *dir = opendir(directory.c_str());
+  if (dir == nullptr)
+  {
+    cout << "Failed to open directory: " << directory << endl;
+    return false;
+  }
+
+  const string extension = ".scn";
+  const string prefix = (directory.back() == '/') ? directory : directory + "/";
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr)
+  {
+    string name = entry->d_name;
+    if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+    {
+      out_files->push_back(prefix + name);
+    }
+  }
+
+  closedir(dir);
+
+  sort(out_files->begin(), out_files->end());
+  return true;
+}
+
+void RegressionRunner::runScenario(const string &scenarioFile, bool updateBaseline, Result *out_result) const
+{
+  out_result->scenarioFile = scenarioFile;
+  out_result->message.clear();
+
+  Scenario scenario;
+  Simulation sim;
+  if (!scenario.load(scenarioFile))
+  {
+    out_result->status = ERROR;
+    out_result->message = "  (" + scenario.error() + ")";
+    return;
+  }
+
+  if (!sim.init(scenario, false))
+  {
+    out_result->status = ERROR;
+    out_result->message = "  (" + sim.error() + ")";
+    return;
+  }
+
+  sim.run();
+
+  string baselineFile = scenarioFile.substr(0, scenarioFile.size() - 4) + ".baseline";
+  if (updateBaseline)
+  {
+    if (!sim.writeMetrics(baselineFile))
+    {
+      out_result->status = ERROR;
+      out_result->message = "  (failed to write baseline: " + baselineFile + ")";
+      return;
+    }
+
+    out_result->status = NEW;
+    return;
+  }
+
+  compare(sim.metrics(), baselineFile, out_result);
+}
+
+void RegressionRunner::compare(const Simulation::Metrics &metrics, const string &baselineFile, Result *out_result) const
+{
+  const double behaviorFloor = 1.0; //Values smaller than this are compared with absolute tolerance
+  const double performanceFloor = 0.05; //Increase of update time below this is ignored [ms]
+
+  ConfigFile baseline;
+  if (!baseline.load(baselineFile))
+  {
+    out_result->status = NEW;
+    out_result->message = "  (no baseline, run with -u)";
+    return;
+  }
+
+  out_result->status = PASS;
+  ostringstream message;
+
+  auto check = [&](const string &key, double value) {
+    double expected = atof(baseline.get("", key, "0").c_str());
+    if (fabs(value - expected) > _behaviorTolerance * max(fabs(expected), behaviorFloor))
+    {
+      out_result->status = FAIL;
+      message << "  " << key << ": " << value << " (baseline " << expected << ")";
+    }
+  };
+
+  check("sim_time", metrics.simTime);
+  check("ticks", metrics.tickNum);
+  check("updates", metrics.updateCount);
+  check("min_gap", metrics.minGap);
+  check("mean_gap", metrics.meanGap);
+  check("mean_velocity", metrics.meanVelocity);
+  check("max_deviation", metrics.maxDeviation);
+  check("mean_deviation", metrics.meanDeviation);
+
+  double expectedTime = atof(baseline.get("", "update_time_ms", "0").c_str());
+  if (metrics.updateTime > expectedTime * (1.0 + _performanceTolerance) + performanceFloor)
+  {
+    if (out_result->status == PASS)
+    {
+      out_result->status = SLOW;
+    }
+    message << "  update_time_ms: " << metrics.updateTime << " (baseline " << expectedTime << ")";
+  }
+
+  // Baselines written before memory accounting have no footprint
+  string expectedMemoryValue = baseline.get("", "memory_bytes", "");
+  double expectedMemory = atof(expectedMemoryValue.c_str());
+  if (!expectedMemoryValue.empty() && metrics.memoryBytes > expectedMemory * (1.0 + _memoryTolerance))
+  {
+    if (out_result->status == PASS)
+    {
+      out_result->status = MEMORY;
+    }
+    message << "  memory_bytes: " << metrics.memoryBytes << " (baseline " << expectedMemory << ")";
+  }
+
+  out_result->message = message.str();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file RegressionRunner.hpp
+ * @author @jonatechout
+ * @brief Runs a directory of scenarios without visualization and compares their metrics with baselines.
+ */
+#ifndef REGRESSIONRUNNER_H
+#define REGRESSIONRUNNER_H
+
+#include <string>
+#include <vector>
+#include "Simulation.hpp"
+
+/**
+ * @class RegressionRunner
+ * @brief Runs a directory of scenarios without visualization and compares their metrics with baselines.
+ * Each "<name>.scn" is compared with "<name>.baseline" in the same directory, which is written with update mode.
+ * Behavior metrics (time, updates, gaps, velocity, deviation from the reference run) must match within a relative tolerance,
+ * update time must not exceed the baseline by more than the performance tolerance,
+ * memory footprint must not exceed the baseline by more than the memory tolerance.
+ */
+class RegressionRunner
+{
+public:
+  enum Status
+  {
+    PASS,    ///< Metrics match the baseline
+    FAIL,    ///< Behavior differs from the baseline
+    SLOW,    ///< Behavior matches, but update time exceeds the baseline
+    MEMORY,  ///< Behavior matches, but memory footprint exceeds the baseline
+    NEW,     ///< No baseline (written in update mode)
+    ERROR    ///< Failed to load or run the scenario
+  };
+
+  struct Result
+  {
+    std::string scenarioFile; ///< Path of the scenario file
+    Status status;            ///< Result of comparison
+    std::string message;      ///< Differences from the baseline, or reason of error
+  };
+
+  RegressionRunner();
+  virtual ~RegressionRunner();
+
+  /**
+   * @brief Set number of scenarios to run at the same time.
+   *
+   * @param threadNum 0: number of hardware threads
+   */
+  void setThreadNum(unsigned int threadNum);
+
+  /**
+   * @brief Set tolerances of comparison.
+   *
+   * @param behaviorTolerance Relative tolerance of behavior metrics
+   * @param performanceTolerance Relative increase of update time
+   * @param memoryTolerance Relative increase of memory footprint
+   */
+  void setTolerance(double behaviorTolerance, double performanceTolerance, double memoryTolerance);
+
+  /**
+   * @brief Run all the scenarios in a directory and print results.
+   *
+   * @param directory Directory of "*.scn" files
+   * @param updateBaseline Overwrite baselines with the current metrics
+   * @return true  All the scenarios pass (or baselines are updated).
+   * @return false  Behavior or performance regression, error, missing baseline or no scenario.
+   */
+  bool run(const std::string &directory, bool updateBaseline);
+
+  const std::vector<Result> &results() const { return _results; }
+
+protected:
+  /**
+   * @brief List scenario files in a directory, sorted by name.
+   *
+   * @param directory
+   * @param out_files
+   * @return true  Directory is read.
+   * @return false  Failed to open.
+   */
+  static bool listScenarios(const std::string &directory, std::vector<std::string> *out_files);
+
+  /**
+   * @brief Run a scenario and compare with its baseline.
+   *
+   * @param scenarioFile
+   * @param updateBaseline
+   * @param out_result
+   */
+  void runScenario(const std::string &scenarioFile, bool updateBaseline, Result *out_result) const;
+
+  /**
+   * @brief Compare metrics with a baseline file.
+   *
+   * @param metrics
+   * @param baselineFile
+   * @param out_result
+   */
+  void compare(const Simulation::Metrics &metrics, const std::string &baselineFile, Result *out_result) const;
+
+  unsigned int _threadNum;      ///< Number of scenarios at the same time (0: number of hardware threads)
+  double _behaviorTolerance;    ///< Relative tolerance of behavior metrics
+  double _performanceTolerance; ///< Relative increase of update time allowed
+  double _memoryTolerance;      ///< Relative increase of memory footprint allowed
+  std::vector<Result> _results; ///< Results of the last run
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file RoadModel.cpp
+ * @author @jonatechout
+ * @brief Road with parallel lanes along the path of an ego car.
+ */
+#include "RoadModel.hpp"
+
+using namespace std;
+
+RoadModel::RoadModel() : _path(),
+                         _laneNum(1),
+                         _laneWidth(3.5)
+{
+}
+
+RoadModel::~RoadModel()
+{
+}
+
+void RoadModel::init(const vector<Car::PositionData> &path, unsigned int laneNum, double laneWidth)
+{
+  _laneNum = laneNum;
+  _laneWidth = laneWidth;
+
+  _path.clear();
+  _path.setMaxSize(path.size());
+  for (const auto &point : path)
+  {
+    _path.push(point);
+  }
+}
+
+double RoadModel::project(double x, double y, double *hint) const
+{
+  return _path.project(x, y, hint);
+}
+
+Car::PositionData RoadModel::pointAt(double s, double offset) const
+{
+  Car::PositionData point = _path.pointAt(s);
+
+  double cosDir, sinDir;
+  _path.directionAt(s, &cosDir, &sinDir);
+
+  // Left normal of the path
+  point.x -= sinDir * offset;
+  point.y += cosDir * offset;
+
+  return point;
+}
+
+void RoadModel::getLanePath(unsigned int lane, double interval, vector<Car::PositionData> *out_path) const
+{
+  out_path->clear();
+
+  if (_path.empty())
+  {
+    return;
+  }
+
+  for (double s = _path.front().s; s < _path.back().s; s += interval)
+  {
+    out_path->push_back(pointAt(s, laneOffset(lane)));
+  }
+
+  out_path->push_back(pointAt(_path.back().s, laneOffset(lane)));
+}
@@ -0,0 +1,81 @@
+/**
+ * @file RoadModel.hpp
+ * @author @jonatechout
+ * @brief Road with parallel lanes along the path of an ego car.
+ */
+#ifndef ROADMODEL_H
+#define ROADMODEL_H
+
+#include <vector>
+#include "Car.hpp"
+#include "PathHistory.hpp"
+
+/**
+ * @class RoadModel
+ * @brief Road with parallel lanes along the path of an ego car.
+ * Lane 0 is the path itself, lane 1, 2, ... are on its right side at lateral offsets of lane width.
+ * Positions on the road are given as arc-length along the path and lateral offset (left: positive).
+ */
+class RoadModel
+{
+public:
+  RoadModel();
+  virtual ~RoadModel();
+
+  /**
+   * @brief Build the road from a path.
+   *
+   * @param path Whole path of the ego car (e.g. PlaybackCar::getWholePath)
+   * @param laneNum Number of lanes
+   * @param laneWidth Width of a lane [m]
+   */
+  void init(const std::vector<Car::PositionData> &path, unsigned int laneNum, double laneWidth);
+
+  /**
+   * @brief Get the arc-length of the closest point on the path.
+   *
+   * @param x X [m] (world coordinate)
+   * @param y Y [m] (world coordinate)
+   * @param hint Arc-length to start searching from, updated with the result. (See PathHistory::project)
+   * @return double Arc-length [m]
+   */
+  double project(double x, double y, double *hint) const;
+
+  /**
+   * @brief Get the point at given arc-length and lateral offset.
+   *
+   * @param s Arc-length [m]
+   * @param offset Lateral offset [m] (left: positive)
+   * @return Car::PositionData Point on the road
+   */
+  Car::PositionData pointAt(double s, double offset) const;
+
+  /**
+   * @brief Get the center line of a lane for visualization.
+   *
+   * @param lane
+   * @param interval Distance between points [m]
+   * @param out_path Center line
+   */
+  void getLanePath(unsigned int lane, double interval, std::vector<Car::PositionData> *out_path) const;
+
+  /**
+   * @brief Returns lateral offset of the center of a lane [m].
+   */
+  double laneOffset(unsigned int lane) const { return -(lane * _laneWidth); }
+
+  /**
+   * @brief Returns bytes of the path.
+   */
+  size_t memoryUsage() const { return _path.memoryUsage(); }
+
+  unsigned int laneNum() const { return _laneNum; }
+  double laneWidth() const { return _laneWidth; }
+
+protected:
+  PathHistory _path;     ///< Path of the ego car (center of lane 0)
+  unsigned int _laneNum; ///< Number of lanes
+  double _laneWidth;     ///< Width of a lane [m]
+};
+
+#endif
@@ -0,0 +1,371 @@
+/**
+ * @file Scenario.cpp
+ * @author @jonatechout
+ * @brief Description of a run: leaders, followers, controllers, simulation settings and output sinks.
+ */
+#include "Scenario.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "ConfigFile.hpp"
+
+using namespace std;
+
+namespace
+{
+bool toDouble(const string &text, double *out_value)
+{
+  char *end = nullptr;
+  *out_value = strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
+
+vector<string> splitList(const string &text)
+{
+  vector<string> items;
+  string item;
+  istringstream stream(text);
+
+  while (getline(stream, item, ','))
+  {
+    size_t begin = item.find_first_not_of(" \t");
+    size_t end = item.find_last_not_of(" \t");
+    if (begin != string::npos)
+    {
+      items.push_back(item.substr(begin, end - begin + 1));
+    }
+  }
+
+  return items;
+}
+}
+
+Scenario::Scenario() : name("default"),
+                       period(0.02),
+                       duration(0.0),
+                       windowWidth(1000),
+                       windowHeight(800),
+                       scale(5.0),
+                       pathInterval(2.0),
+                       v2vLatency(0.0),
+                       v2vJitter(0.0),
+                       v2vDropRate(0.0),
+                       seed(0),
+                       laneNum(1),
+                       laneWidth(3.5),
+                       integrator("euler"),
+                       maxSubstep(0.0),
+                       maxHeadingStep(0.0),
+                       referenceSubstep(0.0)
+{
+}
+
+Scenario::~Scenario()
+{
+}
+
+void Scenario::addLeader(const vector<string> &files, unsigned int followerNum)
+{
+  LeaderConfig leader;
+  leader.files = files;
+  leader.processNoise = 0.1;
+  leader.measurementNoise = 0.5;
+
+  FollowerConfig follower;
+  follower.controller = "linear";
+  follower.lane = 0;
+  leader.followers.assign(followerNum, follower);
+
+  leaders.push_back(leader);
+}
+
+bool Scenario::load(const string &filepath)
+{
+  _error.clear();
+
+  ConfigFile config;
+  if (!config.load(filepath))
+  {
+    _error = "Failed to read scenario file: " + filepath;
+    return false;
+  }
+
+  // INS files are relative to the scenario file
+  size_t slash = filepath.find_last_of('/');
+  string baseDir = (slash == string::npos) ? "" : filepath.substr(0, slash + 1);
+
+  *this = Scenario();
+  name = filepath.substr(slash == string::npos ? 0 : slash + 1);
+  name = name.substr(0, name.find_last_of('.'));
+
+  for (const auto &section : config.sections())
+  {
+    // Parameters of all the followers and of each follower, applied after all the keys are read
+    string controller = "linear";
+    vector<pair<string, string> > followerKeys;
+    unsigned int followerNum = 2;
+    unsigned int lane = 0;
+    LeaderConfig leader;
+    leader.processNoise = 0.1;
+    leader.measurementNoise = 0.5;
+
+    ManeuverConfig maneuver;
+    maneuver.time = -1.0;
+    maneuver.vehicle = -1;
+    maneuver.leader = -1;
+    maneuver.lane = -1;
+
+    for (const auto &entry : section.entries)
+    {
+      const string &key = entry.first;
+      const string &value = entry.second;
+      double number = 0.0;
+      bool isNumber = toDouble(value, &number);
+      bool known = true;
+
+      if (section.name.empty())
+      {
+        if (key == "name")
+        {
+          name = value;
+        }
+        else if (key == "period" && isNumber && number > 0.0)
+        {
+          period = number;
+        }
+        else if (key == "duration" && isNumber && number >= 0.0)
+        {
+          duration = number;
+        }
+        else if (key == "window" && sscanf(value.c_str(), "%dx%d", &windowWidth, &windowHeight) == 2)
+        {
+          // Width and height are parsed
+        }
+        else if (key == "scale" && isNumber && number > 0.0)
+        {
+          scale = number;
+        }
+        else if (key == "path_interval" && isNumber && number > 0.0)
+        {
+          pathInterval = number;
+        }
+        else if (key == "v2v_latency" && isNumber)
+        {
+          v2vLatency = number;
+        }
+        else if (key == "v2v_jitter" && isNumber)
+        {
+          v2vJitter = number;
+        }
+        else if (key == "v2v_drop_rate" && isNumber)
+        {
+          v2vDropRate = number;
+        }
+        else if (key == "seed" && isNumber)
+        {
+          seed = static_cast<uint64_t>(number);
+        }
+        else if (key == "lanes" && isNumber && number >= 1.0)
+        {
+          laneNum = static_cast<unsigned int>(number);
+        }
+        else if (key == "lane_width" && isNumber && number > 0.0)
+        {
+          laneWidth = number;
+        }
+        else if (key == "integrator")
+        {
+          integrator = value;
+        }
+        else if (key == "max_substep" && isNumber && number >= 0.0)
+        {
+          maxSubstep = number;
+        }
+        else if (key == "max_heading_step" && isNumber && number >= 0.0)
+        {
+          maxHeadingStep = number;
+        }
+        else if (key == "reference_substep" && isNumber && number >= 0.0)
+        {
+          referenceSubstep = number;
+        }
+        else
+        {
+          known = false;
+        }
+      }
+      else if (section.name == "leader")
+      {
+        if (key == "ins")
+        {
+          for (const auto &file : splitList(value))
+          {
+            leader.files.push_back((file.front() == '/') ? file : baseDir + file);
+          }
+        }
+        else if (key == "followers" && isNumber && number >= 0.0)
+        {
+          followerNum = static_cast<unsigned int>(number);
+        }
+        else if (key == "controller")
+        {
+          controller = value;
+        }
+        else if (key == "lane" && isNumber && number >= 0.0)
+        {
+          lane = static_cast<unsigned int>(number);
+        }
+        else if (key == "kalman_process_noise" && isNumber)
+        {
+          leader.processNoise = number;
+        }
+        else if (key == "kalman_measurement_noise" && isNumber)
+        {
+          leader.measurementNoise = number;
+        }
+        else
+        {
+          followerKeys.push_back(entry);
+        }
+      }
+      else if (section.name == "maneuver")
+      {
+        if (key == "time" && isNumber && number >= 0.0)
+        {
+          maneuver.time = number;
+        }
+        else if (key == "vehicle" && isNumber && number >= 0.0)
+        {
+          maneuver.vehicle = static_cast<int>(number);
+        }
+        else if (key == "leader" && isNumber && number >= 0.0)
+        {
+          maneuver.leader = static_cast<int>(number);
+        }
+        else if (key == "lane" && isNumber && number >= 0.0)
+        {
+          maneuver.lane = static_cast<int>(number);
+        }
+        else
+        {
+          known = false;
+        }
+      }
+      else if (section.name == "output")
+      {
+        if (key == "record")
+        {
+          recordFile = (value.empty() || value.front() == '/') ? value : baseDir + value;
+        }
+        else if (key == "telemetry")
+        {
+          telemetryEndpoint = value;
+        }
+        else if (key == "metrics")
+        {
+          metricsFile = (value.empty() || value.front() == '/') ? value : baseDir + value;
+        }
+        else
+        {
+          known = false;
+        }
+      }
+      else
+      {
+        return fail(filepath + ":" + to_string(section.line) + ": Unknown section [" + section.name + "]");
+      }
+
+      if (!known)
+      {
+        return fail(filepath + ": Unknown key or wrong value: " + key + " = " + value);
+      }
+    }
+
+    if (section.name == "maneuver")
+    {
+      if (maneuver.time < 0.0 || maneuver.vehicle < 0)
+      {
+        return fail(filepath + ":" + to_string(section.line) + ": [maneuver] needs time and vehicle");
+      }
+
+      maneuvers.push_back(maneuver);
+      continue;
+    }
+
+    if (section.name != "leader")
+    {
+      continue;
+    }
+
+    if (leader.files.empty())
+    {
+      return fail(filepath + ":" + to_string(section.line) + ": No INS file in [leader]");
+    }
+
+    FollowerConfig follower;
+    follower.controller = controller;
+    follower.lane = lane;
+    leader.followers.assign(followerNum, follower);
+
+    // Parameters of all the followers, or of a follower with "follower<N>." prefix
+    for (const auto &entry : followerKeys)
+    {
+      const string &key = entry.first;
+      unsigned int index = 0;
+      int prefixLength = 0;
+      bool isFollowerKey = sscanf(key.c_str(), "follower%u.%n", &index, &prefixLength) == 1 && prefixLength > 0;
+      string param = key.substr(prefixLength);
+
+      if (isFollowerKey && (index < 1 || index > followerNum))
+      {
+        return fail(filepath + ": No such follower: " + key);
+      }
+
+      double number = 0.0;
+      bool isNumber = toDouble(entry.second, &number);
+
+      if (isFollowerKey && param == "controller")
+      {
+        leader.followers.at(index - 1).controller = entry.second;
+      }
+      else if (isFollowerKey && param == "lane" && isNumber && number >= 0.0)
+      {
+        leader.followers.at(index - 1).lane = static_cast<unsigned int>(number);
+      }
+      else if (isFollowerKey && isNumber)
+      {
+        leader.followers.at(index - 1).params[param] = number;
+      }
+      else if (isNumber)
+      {
+        leader.params[param] = number;
+      }
+      else
+      {
+        return fail(filepath + ": Unknown key or wrong value: " + key + " = " + entry.second);
+      }
+    }
+
+    leaders.push_back(leader);
+  }
+
+  if (leaders.empty())
+  {
+    return fail(filepath + ": No [leader] section");
+  }
+
+  stable_sort(maneuvers.begin(), maneuvers.end(),
+              [](const ManeuverConfig &a, const ManeuverConfig &b) { return a.time < b.time; });
+
+  return true;
+}
+
+bool Scenario::fail(const string &message)
+{
+  _error = message;
+  cout << message << endl;
+
+  return false;
+}
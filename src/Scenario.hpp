@@ -0,0 +1,145 @@
+/**
+ * @file Scenario.hpp
+ * @author @jonatechout
+ * @brief Description of a run: leaders, followers, controllers, simulation settings and output sinks.
+ */
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @class Scenario
+ * @brief Description of a run: leaders, followers, controllers, simulation settings and output sinks.
+ * Loaded from a scenario file, for example
+ *
+ *   name = highway            # global settings
+ *   period = 0.02             # update period [s]
+ *   duration = 60             # [s] (0: until the end of INS data)
+ *   window = 1000x800         # visualization window [pix]
+ *   scale = 5.0               # visualization scale
+ *   path_interval = 2.0       # thinning of the whole path [m]
+ *   v2v_latency = 0.1         # [s]
+ *   v2v_jitter = 0.04         # [s]
+ *   v2v_drop_rate = 0.1
+ *   seed = 1                  # random seed of V2V delay and loss
+ *   lanes = 2                 # lanes along the path of each ego car (1: followers follow the path of their leading cars)
+ *   lane_width = 3.5          # [m]
+ *   integrator = rk4          # motion of followers: euler, semi_implicit or rk4
+ *   max_substep = 0.02        # [s] split a period into sub-steps no longer than this (0: no limit)
+ *   max_heading_step = 0.05   # [rad] split a period so that heading changes less than this in a sub-step (0: no limit)
+ *   reference_substep = 0.001 # [s] also run rk4 with this sub-step and measure deviation from it (0: no reference)
+ *
+ *   [leader]                  # one section per ego car
+ *   ins = drive1.csv,drive2.csv   # relative to the scenario file
+ *   followers = 3
+ *   controller = cacc         # linear, idm or cacc
+ *   timeGap = 0.8             # parameter of all the followers which have it (member name of the policy)
+ *   follower2.controller = idm    # controller of 2nd follower (1 is the closest to the leader)
+ *   follower2.desiredVelocity = 15  # parameter of 2nd follower, which must have it
+ *   kalman_process_noise = 0.1
+ *   kalman_measurement_noise = 0.5
+ *   lane = 0                  # lane of all the followers (0: path of the ego car, 1, 2...: right side of it)
+ *   follower3.lane = 1
+ *
+ *   [maneuver]                # change the leading car or lane while running
+ *   time = 20                 # [s]
+ *   vehicle = 4               # vehicle ID of a follower (ego cars first, then followers of each ego car in order)
+ *   leader = 2                # vehicle ID of the new leading car (on the same road if lanes > 1)
+ *   lane = 0                  # new lane
+ *
+ *   [output]
+ *   record = run.trj          # trajectory file for replay
+ *   telemetry = 47000         # TCP port or Unix domain socket path
+ *   metrics = run.metrics     # metrics at the end of run
+ */
+class Scenario
+{
+public:
+  struct FollowerConfig
+  {
+    std::string controller;               ///< Name of controller (linear, idm, cacc)
+    std::map<std::string, double> params; ///< Controller parameters by name
+    unsigned int lane;                    ///< Lane to start on
+  };
+
+  struct LeaderConfig
+  {
+    std::vector<std::string> files;        ///< INS files of the drive
+    std::map<std::string, double> params;  ///< Controller parameters of all the followers (ignored by controllers without them)
+    double processNoise;                   ///< Process noise of Kalman filter per second
+    double measurementNoise;               ///< Measurement noise of Kalman filter [m^2]
+    std::vector<FollowerConfig> followers; ///< Following cars, the first one follows the leader
+  };
+
+  struct ManeuverConfig
+  {
+    double time;  ///< Time to start [s]
+    int vehicle;  ///< Vehicle ID of the follower
+    int leader;   ///< Vehicle ID of the new leading car (-1: not changed)
+    int lane;     ///< New lane (-1: not changed)
+  };
+
+  Scenario();
+  virtual ~Scenario();
+
+  /**
+   * @brief Load a scenario file.
+   *
+   * @param filepath
+   * @return true  Scenario is loaded.
+   * @return false  Failed to open or wrong content.
+   */
+  bool load(const std::string &filepath);
+
+  /**
+   * @brief Add a leader with followers of the default controller.
+   *
+   * @param files INS files of the drive
+   * @param followerNum Number of following cars
+   */
+  void addLeader(const std::vector<std::string> &files, unsigned int followerNum);
+
+  const std::string &error() const { return _error; } ///< Reason why load() failed
+
+  std::string name;           ///< Name of the scenario
+  double period;              ///< Update period [s]
+  double duration;            ///< Simulation time [s] (0: until the end of INS data)
+  int windowWidth;            ///< Visualization window width [pix]
+  int windowHeight;           ///< Visualization window height [pix]
+  double scale;               ///< Visualization scale
+  double pathInterval;        ///< Minimum distance between points of the whole path [m]
+  double v2vLatency;          ///< Base latency of V2V [s]
+  double v2vJitter;           ///< Maximum additional latency of V2V [s]
+  double v2vDropRate;         ///< Probability of losing a V2V message
+  uint64_t seed;              ///< Random seed of V2V
+  unsigned int laneNum;       ///< Number of lanes along the path of each ego car
+  double laneWidth;           ///< Width of a lane [m]
+  std::string integrator;     ///< Integration method of followers (euler, semi_implicit, rk4)
+  double maxSubstep;          ///< Maximum sub-step of followers [s] (0: no limit)
+  double maxHeadingStep;      ///< Maximum heading change in a sub-step of followers [rad] (0: no limit)
+  double referenceSubstep;    ///< Sub-step of the fine-step reference run [s] (0: no reference)
+
+  std::vector<LeaderConfig> leaders; ///< Ego cars and their followers
+  std::vector<ManeuverConfig> maneuvers; ///< Changes of leading car or lane, in order of time
+
+  std::string recordFile;        ///< Trajectory file to record (empty: none)
+  std::string telemetryEndpoint; ///< Telemetry port or socket path (empty: none)
+  std::string metricsFile;       ///< File to write metrics (empty: none)
+
+protected:
+  /**
+   * @brief Keep and print the reason of a failure.
+   *
+   * @param message
+   * @return false  Always, to be returned by the caller.
+   */
+  bool fail(const std::string &message);
+
+  std::string _error; ///< Reason why load() failed
+};
+
+#endif
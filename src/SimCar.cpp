@@ -7,86 +7,152 @@
 
 using namespace std;
 
+namespace
+{
+const double restVelocity = 0.05; //Velocity regarded as stopped, same as PlaybackCar [m/s]
+}
+
 SimCar::SimCar() : _leadingCar(nullptr),
-                   _leadingCarHistory()
+                   _leadingCarHistory(),
+                   _arcLengthHint(-1.0),
+                   _leaderPrevVelocity(-1.0),
+                   _leaderRestTime(0.0),
+                   _prevVelocity(0.0),
+                   _gap(-1.0),
+                   _prevGap(-1.0),
+                   _road(nullptr),
+                   _lane(0),
+                   _laneOffset(0.0),
+                   _leaderArcLengthHint(-1.0),
+                   _bus(nullptr),
+                   _busId(0),
+                   _leaderBusId(0),
+                   _leaderMessage(),
+                   _hasLeaderMessage(false),
+                   _model()
 {
+  const int historySize = 100; //History size
+
+  _leadingCarHistory.setMaxSize(historySize);
 }
 
 SimCar::~SimCar()
 {
 }
 
-void SimCar::update()
+bool SimCar::observeLeadingCar(double lookahead, PositionData *out_followPoint, LongitudinalState *out_state)
 {
   const double historyInterval = 0.5;   //Minimum distance between history points
-  const int historySize = 100;          //History size
-  const double distToFollowPoint = 5.0; //Distance to the point to follow on path
-  const double wheelBase = 2.5;         //Wheel base
-  const double interVehicleTime = 3.0;  //Target inter-vehicle time to calculate the target distance to leading car
-  const double stopDistance = 5.0;      //Distance to stop before leading car
-  const double accCoeffDist = 0.05;     //Parameter of acceleration calculation
-  const double accCoeffVel = 0.4;       //Parameter of acceleration calculation
+  const double laneChangeVelocity = 1.0; //Lateral velocity of the point to follow in lane change [m/s]
 
   _currentTime += _periodTime;
 
-  if (_leadingCar != nullptr &&
-      (_leadingCarHistory.empty() || _leadingCar->distanceTo(_leadingCarHistory.back()) > historyInterval))
-  {
-    //Store the leading car's position in history data
-    PositionData hist;
-    hist.timestamp = _currentTime;
-    hist.x = _leadingCar->x();
-    hist.y = _leadingCar->y();
+  LeaderState leader;
+  bool hasLeader = getLeaderState(&leader);
 
-    _leadingCarHistory.push_back(hist);
+  if (_road != nullptr)
+  {
+    if (!hasLeader)
+    {
+      return false;
+    }
 
-    if (_leadingCarHistory.size() > historySize)
+    // Arc-length of own position and the leading car on the road. The leading car is searched from own position
+    // when unknown, so a new leading car is found without searching the whole road.
+    double arcLength = _road->project(_x, _y, &_arcLengthHint);
+    if (_leaderArcLengthHint < 0.0)
     {
-      _leadingCarHistory.pop_front();
+      _leaderArcLengthHint = arcLength;
     }
-  }
+    double leaderArcLength = _road->project(leader.x, leader.y, &_leaderArcLengthHint);
+
+    // Move the point to follow toward the own lane
+    double maxShift = laneChangeVelocity * _periodTime;
+    _laneOffset += min(max(_road->laneOffset(_lane) - _laneOffset, -maxShift), maxShift);
 
-  if (_leadingCarHistory.empty())
+    *out_followPoint = _road->pointAt(arcLength + lookahead, _laneOffset);
+    out_state->gap = max(leaderArcLength - arcLength, 0.0);
+  }
+  else
   {
-    return;
+    if (hasLeader &&
+        (_leadingCarHistory.empty() || distanceBetween(_leadingCarHistory.back(), leader.x, leader.y) > historyInterval))
+    {
+      //Store the leading car's position in history data
+      PositionData hist;
+      hist.timestamp = _currentTime;
+      hist.x = leader.x;
+      hist.y = leader.y;
+
+      _leadingCarHistory.push(hist);
+    }
+
+    if (!hasLeader || _leadingCarHistory.empty())
+    {
+      return false;
+    }
+
+    // Arc-length of own position on leading car history
+    double arcLength = _leadingCarHistory.project(_x, _y, &_arcLengthHint);
+
+    // Point to aim
+    *out_followPoint = _leadingCarHistory.pointAt(arcLength + lookahead);
+
+    // Calculate the distance along the path of leading car.
+    // The leading car is beyond the last history point by less than historyInterval.
+    const PathHistory::PathPoint &lastHist = _leadingCarHistory.back();
+    double leaderArcLength = lastHist.s + distanceBetween(lastHist, leader.x, leader.y);
+
+    out_state->gap = max(leaderArcLength - arcLength, 0.0);
   }
 
-  // Get the index of closest point in leading car history
-  int closestIndex = getClosestHitoryIndex(this);
+  _leaderRestTime = (leader.velocity < restVelocity) ? _leaderRestTime + _periodTime : 0.0;
 
-  // Get the index of point to aim
-  int followPointIndex = min(
-    static_cast<int>(distToFollowPoint / historyInterval) + closestIndex,
-    static_cast<int>(_leadingCarHistory.size()) - 1);
+  _prevGap = _gap;
+  _gap = out_state->gap;
+  out_state->velocity = _velocity;
+  out_state->leaderVelocity = leader.velocity;
+  out_state->leaderAccel = leader.accel;
 
-  // Calculate tyre angle to go to the following point
-  double tyreAngle = getTargetTyreAngle(_leadingCarHistory.at(followPointIndex));
-  double yawrate = _velocity * tan(tyreAngle) / wheelBase;
+  return true;
+}
 
-  // Calculate the distance and speed of leading car
-  int leaderClosestIndex = getClosestHitoryIndex(_leadingCar);
-  double distToLeader = max((leaderClosestIndex - closestIndex) * historyInterval, 0.0);
-  double leaderVel = _leadingCar->velocity();
+bool SimCar::getLeaderState(LeaderState *out_state)
+{
+  if (_bus != nullptr)
+  {
+    // Keep the newest message, older ones may arrive late because of jitter
+    V2VBus::StateMessage message;
+    if (_bus->receive(_leaderBusId, _busId, &message) &&
+        (!_hasLeaderMessage || message.tick > _leaderMessage.tick))
+    {
+      _leaderMessage = message;
+      _hasLeaderMessage = true;
+    }
 
-  double targetRange = _velocity * interVehicleTime + stopDistance;
+    out_state->x = _leaderMessage.x;
+    out_state->y = _leaderMessage.y;
+    out_state->velocity = _leaderMessage.velocity;
+    out_state->accel = _leaderMessage.accel;
 
-  // Target acceleration
-  double targetAccel = accCoeffDist * (distToLeader - targetRange) + accCoeffVel * (leaderVel - _velocity);
+    return _hasLeaderMessage;
+  }
 
-  if (distToLeader < stopDistance)
+  if (_leadingCar == nullptr)
   {
-    // If the leading car is very close, decelerate strongly
-    targetAccel = -5.0;
+    return false;
   }
 
-  // Update vehicle state
-  _velocity += targetAccel * _periodTime;
-  _velocity = max(_velocity, 0.0);
+  double leaderVel = _leadingCar->velocity();
+
+  out_state->x = _leadingCar->x();
+  out_state->y = _leadingCar->y();
+  out_state->velocity = leaderVel;
+  out_state->accel = (_leaderPrevVelocity < 0.0) ? 0.0 : (leaderVel - _leaderPrevVelocity) / _periodTime;
 
-  _x += _velocity * cos(_heading) * _periodTime;
-  _y += _velocity * sin(_heading) * _periodTime;
+  _leaderPrevVelocity = leaderVel;
 
-  _heading += yawrate * _periodTime;
+  return true;
 }
 
 void SimCar::setLeadingCar(const Car *leadingCar)
@@ -96,39 +162,81 @@ void SimCar::setLeadingCar(const Car *leadingCar)
     return;
   }
 
-  _leadingCarHistory.clear();
+  // Keep the recorded path behind the new leading car (cut-in) or own position (new leading car is further ahead).
+  // Only the dropped points are visited, at most the size of history.
+  if (!_leadingCarHistory.empty())
+  {
+    double arcLength = _leadingCarHistory.project(_x, _y, &_arcLengthHint);
+    double leaderHint = arcLength;
+    double leaderArcLength = _leadingCarHistory.project(leadingCar->x(), leadingCar->y(), &leaderHint);
+
+    _leadingCarHistory.truncate(max(arcLength, leaderArcLength));
+  }
+
+  _leaderArcLengthHint = -1.0;
+  _leaderPrevVelocity = -1.0;
+  _leaderRestTime = 0.0;
+  _gap = -1.0;
+  _prevGap = -1.0;
+  _hasLeaderMessage = false;
   _leadingCar = leadingCar;
 }
 
-double SimCar::getTargetTyreAngle(const PositionData& followPoint)
+void SimCar::setRoad(const RoadModel *road, unsigned int lane)
 {
-  const double tyreAngleLimit = 30.0; //[deg]
+  _road = road;
+  _leaderArcLengthHint = -1.0;
 
-  // Follow point on car coordinate
-  double followX_c = cos(_heading) * (followPoint.x - _x) + sin(_heading) * (followPoint.y - _y);
-  double followY_c = -sin(_heading) * (followPoint.x - _x) + cos(_heading) * (followPoint.y - _y);
+  // Search the whole road once here, later updates search only around the last position
+  _arcLengthHint = -1.0;
+  if (road != nullptr)
+  {
+    road->project(_x, _y, &_arcLengthHint);
+  }
 
-  // Tyre angle is directly toward the follwPoint
-  double tyreAngle = atan2(followY_c, followX_c);
-  tyreAngle = min(tyreAngle, tyreAngleLimit * M_PI / 180.0);
-  tyreAngle = max(tyreAngle, -tyreAngleLimit * M_PI / 180.0);
+  _lane = lane;
+  _laneOffset = (road != nullptr) ? road->laneOffset(lane) : 0.0;
+}
 
-  return tyreAngle;
+void SimCar::setLane(unsigned int lane)
+{
+  _lane = lane;
 }
 
-int SimCar::getClosestHitoryIndex(const Car* car)
+void SimCar::setIntegrationMethod(BicycleModel::IntegrationMethod method)
 {
-  int closestIndex = -1;
-  double minDist = 1e+10;
-  for (unsigned int i = 0; i < _leadingCarHistory.size(); i++)
-  {
-    double currentDist = car->distanceTo(_leadingCarHistory.at(i));
-    if (currentDist < minDist)
-    {
-      closestIndex = i;
-      minDist = currentDist;
-    }
-  }
+  _model.setIntegrationMethod(method);
+}
 
-  return closestIndex;
-}
\ No newline at end of file
+void SimCar::setSubStepping(double maxSubStep, double maxHeadingStep)
+{
+  _model.setSubStepping(maxSubStep, maxHeadingStep);
+}
+
+bool SimCar::canSleep() const
+{
+  const double restTimeToSleep = 1.0; //Longer than V2V latency, so that delayed messages are not missed [s]
+  const double sleepVelocity = 0.01;  //Own velocity to sleep, lower than restVelocity to stop closer to the rest position [m/s]
+
+  bool changingLane = _road != nullptr && _laneOffset != _road->laneOffset(_lane);
+
+  // Gap still closing or opening (e.g. the leading car creeps) changes the control input
+  bool gapIsStable = fabs(_gap - _prevGap) < sleepVelocity * _periodTime;
+
+  // Still approaching the leading car if speeding up
+  return _velocity < sleepVelocity && _velocity <= _prevVelocity && _leaderRestTime >= restTimeToSleep && gapIsStable &&
+         !changingLane;
+}
+
+void SimCar::setV2VBus(const V2VBus *bus, unsigned int selfId, unsigned int leaderId)
+{
+  _bus = bus;
+  _busId = selfId;
+  _leaderBusId = leaderId;
+  _hasLeaderMessage = false;
+}
+
+double SimCar::distanceBetween(const PathHistory::PathPoint &point, double x, double y)
+{
+  return sqrt((point.x - x) * (point.x - x) + (point.y - y) * (point.y - y));
+}
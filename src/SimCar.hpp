@@ -8,14 +8,19 @@
 #define SIMCAR_H
 
 #include "Car.hpp"
+#include "BicycleModel.hpp"
+#include "PathHistory.hpp"
+#include "RoadModel.hpp"
+#include "ControllerPolicy.hpp"
+#include "V2VBus.hpp"
 #include <math.h>
 #include <algorithm>
-#include <deque>
 #include <memory>
 
 /**
  * @class SimCar
- * @brief Simulates following cars motion
+ * @brief Simulates following cars motion. This is an abstract class.
+ * Records the leading car's path and integrates own motion. Control laws are given by FollowerCar.
  */
 class SimCar : public Car
 {
@@ -24,36 +29,165 @@ public:
   virtual ~SimCar();
 
   /**
-   * @brief Update vehicle state.
+   * @brief Set the Leading Car to follow. Can be changed while running (merge, split, cut-in).
+   * The path recorded so far is kept up to the new leading car or own position, whichever is ahead,
+   * so the cost does not depend on the length of the run.
+   * @param leadingCar Pointer to a Car object to follow
    */
-  virtual void update();
+  void setLeadingCar(const Car *leadingCar);
 
   /**
-   * @brief Set the Leading Car to follow
-   * @param leadingCar Pointer to a Car object to follow
+   * @brief Drive along a lane of a road instead of the recorded path of the leading car.
+   * The gap is measured along the road, so the leading car can be on another lane.
+   * Searches own position on the whole road, call after init().
+   * @param road Road (nullptr to follow the recorded path)
+   * @param lane Lane to drive on
    */
-  void setLeadingCar(const Car *leadingCar);
+  void setRoad(const RoadModel *road, unsigned int lane);
+
+  /**
+   * @brief Change the lane to drive on. The point to follow moves to the new lane gradually.
+   * @param lane
+   */
+  void setLane(unsigned int lane);
+
+  unsigned int lane() const { return _lane; }
+
+  /**
+   * @brief Set the Integration method of vehicle motion
+   * @param method
+   */
+  void setIntegrationMethod(BicycleModel::IntegrationMethod method);
+
+  /**
+   * @brief Set the sub-stepping limits of vehicle motion integration. 0 disables the limit.
+   * @param maxSubStep Maximum length of a sub-step [s]
+   * @param maxHeadingStep Maximum heading change in a sub-step [rad]
+   */
+  void setSubStepping(double maxSubStep, double maxHeadingStep);
+
+  /**
+   * @brief Receive the leading car's state through V2V bus instead of reading it directly.
+   * Last received state is used until a newer message arrives.
+   * @param bus V2V bus (nullptr to read the leading car directly)
+   * @param selfId Own vehicle ID on the bus
+   * @param leaderId Vehicle ID of the leading car on the bus
+   */
+  void setV2VBus(const V2VBus *bus, unsigned int selfId, unsigned int leaderId);
+
+  /**
+   * @brief Returns true if stopped (not speeding up), the gap is stable and the leading car has been stopped long enough.
+   * A sleeping follower is woken up when the leading car moves.
+   */
+  virtual bool canSleep() const;
+
+  /**
+   * @brief Returns the distance to the leading car along its path at last update.
+   *
+   * @return double Gap [m] (negative: not observed yet)
+   */
+  double gap() const { return _gap; }
+
+  /**
+   * @brief Returns bytes of the history of the leading car's positions.
+   */
+  size_t historyMemoryUsage() const { return _leadingCarHistory.memoryUsage(); }
+
+  /**
+   * @brief Set a parameter of the control laws by its name.
+   *
+   * @param name Parameter name (e.g. "timeGap")
+   * @param value
+   * @return true  Parameter is set.
+   * @return false  Unknown parameter.
+   */
+  virtual bool setControllerParam(const std::string &name, double value) { return false; }
 
 protected:
+  struct LeaderState
+  {
+    double x;        ///< X [m] (world coordinate)
+    double y;        ///< Y [m] (world coordinate)
+    double velocity; ///< Velocity [m/s]
+    double accel;    ///< Acceleration [m/s^2]
+  };
+
+  /**
+   * @brief Advance time, store the leading car's position in history and observe the leading car.
+   * On a road, the point to follow is on the own lane instead of the history.
+   *
+   * @param lookahead Distance along the path to the point to follow [m]
+   * @param out_followPoint Point to follow
+   * @param out_state Gap and leading car's state
+   * @return true  Observation succeeded.
+   * @return false  No history to follow yet.
+   */
+  bool observeLeadingCar(double lookahead, PositionData *out_followPoint, LongitudinalState *out_state);
+
   /**
-   * @brief Get the index of the closest position data in _leadingCarHistory.
+   * @brief Integrate own motion over one period.
    *
-   * @param car Reference car
-   * @return int Index of history
+   * @param controller Functor which returns BicycleModel::Input for given BicycleModel::State
    */
-  int getClosestHitoryIndex(const Car *car);
+  template <class Controller>
+  void integrateMotion(Controller controller);
 
   /**
-   * @brief Get the target tyre angle, directly toward the following point.
+   * @brief Get the latest known state of the leading car.
    *
-   * @param followPoint Destination point
-   * @return double Tyre angle to reach for the destination point
+   * @param out_state Leading car's state
+   * @return true  State is known.
+   * @return false  No leading car or no message received yet.
    */
-  double getTargetTyreAngle(const PositionData &followPoint);
+  bool getLeaderState(LeaderState *out_state);
+
+  /**
+   * @brief Returns distance between history point and given position.
+   *
+   * @param point History point
+   * @param x
+   * @param y
+   * @return double Distance
+   */
+  static double distanceBetween(const PathHistory::PathPoint &point, double x, double y);
 
   const Car *_leadingCar; ///< Pointer to the leading car
-  std::deque<PositionData> _leadingCarHistory; ///< History of leading car position
+  PathHistory _leadingCarHistory; ///< History of leading car position
+  double _arcLengthHint;          ///< Arc-length of own position on history at last update (-1: unknown)
+  double _leaderPrevVelocity;     ///< Velocity of leading car at last update (-1: unknown)
+  double _leaderRestTime;         ///< Duration the leading car has been stopped [s]
+  double _prevVelocity;           ///< Own velocity before last update [m/s]
+  double _gap;                    ///< Distance to the leading car along its path [m] (-1: unknown)
+  double _prevGap;                ///< Gap before last update [m] (-1: unknown)
+  const RoadModel *_road;         ///< Road to drive on (nullptr: follow the recorded path)
+  unsigned int _lane;             ///< Lane to drive on
+  double _laneOffset;             ///< Lateral offset of the point to follow [m]
+  double _leaderArcLengthHint;    ///< Arc-length of the leading car on the road at last update (-1: unknown)
+  const V2VBus *_bus;             ///< V2V bus to receive the leading car's state (nullptr: read directly)
+  unsigned int _busId;            ///< Own vehicle ID on the bus
+  unsigned int _leaderBusId;      ///< Vehicle ID of the leading car on the bus
+  V2VBus::StateMessage _leaderMessage; ///< Last received message from the leading car
+  bool _hasLeaderMessage;         ///< True if _leaderMessage is valid
+  BicycleModel _model; ///< Vehicle motion model
 
 };
 
-#endif
\ No newline at end of file
+template <class Controller>
+void SimCar::integrateMotion(Controller controller)
+{
+  BicycleModel::State state;
+  state.x = _x;
+  state.y = _y;
+  state.heading = _heading;
+  state.velocity = _velocity;
+
+  _prevVelocity = _velocity;
+  _model.integrate(&state, controller, _periodTime);
+
+  _x = state.x;
+  _y = state.y;
+  _heading = state.heading;
+  _velocity = state.velocity;
+}
+
+#endif
@@ -0,0 +1,599 @@
+/**
+ * @file Simulation.cpp
+ * @author @jonatechout
+ * @brief Builds the cars of a scenario and runs them, with or without visualization.
+ */
+#include "Simulation.hpp"
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include "FollowerCar.hpp"
+#include "InsLoader.hpp"
+#include "ConfigFile.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+Simulation::Simulation() : _nextManeuver(0),
+                           _endTime(0.0),
+                           _frame(0),
+                           _gapSum(0.0),
+                           _gapCount(0),
+                           _velocitySum(0.0),
+                           _velocityCount(0),
+                           _updateTimeSum(0.0),
+                           _deviationSum(0.0),
+                           _deviationCount(0)
+{
+  _metrics.simTime = 0.0;
+  _metrics.tickNum = 0;
+  _metrics.updateCount = 0;
+  _metrics.minGap = -1.0;
+  _metrics.meanGap = 0.0;
+  _metrics.meanVelocity = 0.0;
+  _metrics.updateTime = 0.0;
+  _metrics.memoryBytes = 0;
+  _metrics.maxDeviation = 0.0;
+  _metrics.meanDeviation = 0.0;
+
+  _timing.updateTime = 0.0f;
+  _timing.renderTime = 0.0f;
+  _timing.updateCount = 0;
+}
+
+Simulation::~Simulation()
+{
+}
+
+SimCar *Simulation::createFollower(const string &controller)
+{
+  if (controller == "linear")
+  {
+    return new LinearFollowerCar();
+  }
+  else if (controller == "idm")
+  {
+    return new IdmFollowerCar();
+  }
+  else if (controller == "cacc")
+  {
+    return new CaccFollowerCar();
+  }
+
+  return nullptr;
+}
+
+bool Simulation::createFollowers(const Scenario &scenario, unsigned int leaderIndex,
+                                 vector<unique_ptr<SimCar> > *out_followers, string *out_error)
+{
+  const Scenario::LeaderConfig &config = scenario.leaders.at(leaderIndex);
+  set<string> usedParams;
+
+  BicycleModel::IntegrationMethod method;
+  if (scenario.integrator == "euler")
+  {
+    method = BicycleModel::EULER;
+  }
+  else if (scenario.integrator == "semi_implicit")
+  {
+    method = BicycleModel::SEMI_IMPLICIT;
+  }
+  else if (scenario.integrator == "rk4")
+  {
+    method = BicycleModel::RK4;
+  }
+  else
+  {
+    *out_error = "Unknown integrator: " + scenario.integrator;
+    return false;
+  }
+
+  out_followers->clear();
+  for (const auto &followerConfig : config.followers)
+  {
+    unique_ptr<SimCar> follower(createFollower(followerConfig.controller));
+    if (!follower)
+    {
+      *out_error = "Unknown controller: " + followerConfig.controller;
+      return false;
+    }
+
+    for (const auto &param : config.params)
+    {
+      if (follower->setControllerParam(param.first, param.second))
+      {
+        usedParams.insert(param.first);
+      }
+    }
+
+    for (const auto &param : followerConfig.params)
+    {
+      if (!follower->setControllerParam(param.first, param.second))
+      {
+        *out_error = "Unknown parameter of " + followerConfig.controller + " controller: " + param.first;
+        return false;
+      }
+    }
+
+    follower->setIntegrationMethod(method);
+    follower->setSubStepping(scenario.maxSubstep, scenario.maxHeadingStep);
+
+    out_followers->push_back(move(follower));
+  }
+
+  // A parameter for all the followers must be used by at least one of them
+  for (const auto &param : config.params)
+  {
+    if (!config.followers.empty() && usedParams.count(param.first) == 0)
+    {
+      *out_error = "Unknown parameter of followers: " + param.first;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Simulation::init(const Scenario &scenario, bool enableSinks)
+{
+  _scenario = scenario;
+  _error.clear();
+  const double period = _scenario.period;
+
+  // Load all the drives on a common origin
+  vector<vector<string> > drives;
+  for (const auto &leader : _scenario.leaders)
+  {
+    drives.push_back(leader.files);
+  }
+
+  vector<vector<PlaybackCar::PositionData> > driveData;
+  InsLoader loader;
+  if (!loader.load(drives, &driveData))
+  {
+    // The loader has printed which file failed
+    string files;
+    for (const auto &drive : drives)
+    {
+      for (const auto &file : drive)
+      {
+        files += (files.empty() ? "" : ", ") + file;
+      }
+    }
+
+    return fail("Failed to load INS data: " + files);
+  }
+
+  const unsigned int leaderNum = driveData.size();
+  unsigned int followerNum = 0;
+  for (const auto &leader : _scenario.leaders)
+  {
+    followerNum += leader.followers.size();
+  }
+
+  // Ego cars play loaded INS data
+  _egoCars = vector<PlaybackCar>(leaderNum);
+  _paths.assign(leaderNum, vector<PlaybackCar::PositionData>());
+  _endTime = 0.0;
+
+  for (unsigned int k = 0; k < leaderNum; k++)
+  {
+    const Scenario::LeaderConfig &config = _scenario.leaders.at(k);
+    const vector<PlaybackCar::PositionData> &data = driveData.at(k);
+
+    if (data.empty())
+    {
+      return fail("No data in drive: " + config.files.front());
+    }
+
+    PlaybackCar &egoCar = _egoCars.at(k);
+    egoCar.setData(data);
+    egoCar.init(data.front().x, data.front().y, 0, 0);
+    egoCar.setPeriod(period);
+    egoCar.setKalmanNoise(config.processNoise, config.measurementNoise);
+    egoCar.initKalman();
+
+    // Get a whole path data (thined out) for visualization
+    egoCar.getWholePath(&_paths.at(k), _scenario.pathInterval);
+
+    _endTime = max(_endTime, data.back().timestamp);
+  }
+
+  if (_scenario.duration > 0.0)
+  {
+    _endTime = _scenario.duration;
+  }
+
+  // Lanes beside the path of each ego car
+  _roads.clear();
+  _lanePaths.clear();
+  if (_scenario.laneNum > 1)
+  {
+    _roads.resize(leaderNum);
+    for (unsigned int k = 0; k < leaderNum; k++)
+    {
+      _roads.at(k).init(_paths.at(k), _scenario.laneNum, _scenario.laneWidth);
+
+      for (unsigned int lane = 1; lane < _scenario.laneNum; lane++)
+      {
+        _lanePaths.push_back(vector<PlaybackCar::PositionData>());
+        _roads.at(k).getLanePath(lane, _scenario.pathInterval, &_lanePaths.back());
+      }
+    }
+  }
+
+  // V2V bus which delivers states of leading cars
+  _bus.setChannel(_scenario.v2vLatency, _scenario.v2vJitter, _scenario.v2vDropRate);
+  _bus.setSeed(_scenario.seed);
+  _bus.init(leaderNum + followerNum, period);
+
+  // Ego cars and followers are updated by events, in the same order as vehicle IDs
+  _scheduler.setPeriod(period);
+  _cars.clear();
+  _roadIndices.clear();
+  for (unsigned int k = 0; k < leaderNum; k++)
+  {
+    _scheduler.addCar(&_egoCars.at(k), -1);
+    _cars.push_back(&_egoCars.at(k));
+    _roadIndices.push_back(k);
+  }
+
+  // Initialize following cars
+  _followers.clear();
+  vector<int> leaderIds(leaderNum, -1); // Leading car of each vehicle (-1: ego car)
+  for (unsigned int k = 0; k < leaderNum; k++)
+  {
+    const Scenario::LeaderConfig &config = _scenario.leaders.at(k);
+
+    vector<unique_ptr<SimCar> > followers;
+    string error;
+    if (!createFollowers(_scenario, k, &followers, &error))
+    {
+      return fail(error);
+    }
+
+    for (unsigned int j = 0; j < config.followers.size(); j++)
+    {
+      const Scenario::FollowerConfig &followerConfig = config.followers.at(j);
+      unique_ptr<SimCar> follower = move(followers.at(j));
+
+      unsigned int id = _cars.size();
+      unsigned int leaderId = (j == 0) ? k : id - 1;
+
+      PlaybackCar::PositionData start = _paths.at(k).at(0);
+      if (!_roads.empty())
+      {
+        if (followerConfig.lane >= _scenario.laneNum)
+        {
+          return fail("No such lane: " + to_string(followerConfig.lane));
+        }
+
+        start = _roads.at(k).pointAt(0.0, _roads.at(k).laneOffset(followerConfig.lane));
+      }
+
+      follower->init(start.x, start.y, 0, 0);
+      follower->setPeriod(period);
+      if (!_roads.empty())
+      {
+        follower->setRoad(&_roads.at(k), followerConfig.lane);
+      }
+      follower->setLeadingCar(_cars.at(leaderId));
+      follower->setV2VBus(&_bus, id, leaderId);
+
+      _scheduler.addCar(follower.get(), leaderId);
+      leaderIds.push_back(leaderId);
+      _cars.push_back(follower.get());
+      _roadIndices.push_back(k);
+      _followers.push_back(move(follower));
+    }
+  }
+
+  // Check the maneuvers before running
+  for (const auto &maneuver : _scenario.maneuvers)
+  {
+    int vehicle = maneuver.vehicle;
+    int carNum = _cars.size();
+
+    if (vehicle < static_cast<int>(leaderNum) || vehicle >= carNum)
+    {
+      return fail("Maneuver of vehicle " + to_string(vehicle) + ": not a follower");
+    }
+
+    if (maneuver.leader == vehicle || maneuver.leader >= carNum ||
+        (maneuver.leader >= 0 && !_roads.empty() && _roadIndices.at(maneuver.leader) != _roadIndices.at(vehicle)))
+    {
+      return fail("Maneuver of vehicle " + to_string(vehicle) + ": wrong leading car " + to_string(maneuver.leader));
+    }
+
+    if (maneuver.lane >= 0 && (_roads.empty() || maneuver.lane >= static_cast<int>(_scenario.laneNum)))
+    {
+      return fail("Maneuver of vehicle " + to_string(vehicle) + ": no such lane " + to_string(maneuver.lane));
+    }
+
+    if (maneuver.leader < 0)
+    {
+      continue;
+    }
+
+    // Maneuvers are sorted by time, so the leading cars are known when each one is applied.
+    // Every chain of leading cars must end at an ego car, otherwise the cars chase each other (e.g. a leader behind).
+    leaderIds.at(vehicle) = maneuver.leader;
+    for (int id = maneuver.leader; id >= 0; id = leaderIds.at(id))
+    {
+      if (id == vehicle)
+      {
+        return fail("Maneuver of vehicle " + to_string(vehicle) + ": leading car " + to_string(maneuver.leader) +
+                    " follows it");
+      }
+    }
+  }
+
+  _nextManeuver = 0;
+
+  _scheduler.setTickCallback([this](long long tick) { _bus.advanceTo(tick); });
+  _scheduler.setUpdateCallback([this](unsigned int index, Car *car) { _bus.publish(index, *car); });
+
+  if (enableSinks)
+  {
+    if (!_scenario.telemetryEndpoint.empty() && !_telemetry.open(_scenario.telemetryEndpoint))
+    {
+      _error = "Failed to open telemetry: " + _scenario.telemetryEndpoint;
+      return false;
+    }
+
+    vector<vector<PlaybackCar::PositionData> > recordPaths = _paths;
+    recordPaths.insert(recordPaths.end(), _lanePaths.begin(), _lanePaths.end());
+
+    if (!_scenario.recordFile.empty() &&
+        !_recorder.open(_scenario.recordFile, _cars.size(), period, _scenario.windowWidth, _scenario.windowHeight,
+                        _scenario.scale, recordPaths))
+    {
+      _error = "Failed to open record file: " + _scenario.recordFile;
+      return false;
+    }
+  }
+
+  // Reference run of the same scenario with fine-step integration
+  _reference.reset();
+  if (_scenario.referenceSubstep > 0.0)
+  {
+    Scenario reference = _scenario;
+    reference.integrator = "rk4";
+    reference.maxSubstep = _scenario.referenceSubstep;
+    reference.maxHeadingStep = 0.0;
+    reference.referenceSubstep = 0.0;
+
+    _reference.reset(new Simulation());
+    if (!_reference->init(reference, false))
+    {
+      return fail("Failed to initialize reference run: " + _reference->error());
+    }
+  }
+
+  return true;
+}
+
+void Simulation::step()
+{
+  steady_clock::time_point updateStart = steady_clock::now();
+  unsigned long long updateCount = _scheduler.updateCount();
+
+  // Maneuvers which start in this period
+  while (_nextManeuver < _scenario.maneuvers.size() &&
+         _scenario.maneuvers.at(_nextManeuver).time < _scheduler.currentTime() + _scenario.period * 0.5)
+  {
+    applyManeuver(_scenario.maneuvers.at(_nextManeuver));
+    _nextManeuver++;
+  }
+
+  // Update the state of cars which are awake
+  _frame++;
+  _scheduler.runUntil(_frame * _scenario.period);
+
+  _timing.updateTime = duration<float, milli>(steady_clock::now() - updateStart).count();
+  _timing.updateCount = static_cast<uint32_t>(_scheduler.updateCount() - updateCount);
+
+  if (_recorder.isOpen())
+  {
+    _recorder.writeFrame(_scheduler.currentTime(), _cars);
+  }
+
+  // Deviation of followers from the reference run (not included in the update time)
+  if (_reference)
+  {
+    _reference->step();
+
+    for (unsigned int id = _egoCars.size(); id < _cars.size(); id++)
+    {
+      const Car &car = *_cars.at(id);
+      const Car &reference = *_reference->_cars.at(id);
+      double deviation = sqrt((car.x() - reference.x()) * (car.x() - reference.x()) +
+                              (car.y() - reference.y()) * (car.y() - reference.y()));
+
+      _metrics.maxDeviation = max(_metrics.maxDeviation, deviation);
+      _deviationSum += deviation;
+      _deviationCount++;
+    }
+  }
+
+  // Metrics (gaps while stopped are not counted, followers start at the position of the leader)
+  const double movingVelocity = 1.0; //Minimum velocity to count the gap [m/s]
+
+  for (const auto &follower : _followers)
+  {
+    if (follower->gap() >= 0.0 && follower->velocity() >= movingVelocity)
+    {
+      _metrics.minGap = (_metrics.minGap < 0.0) ? follower->gap() : min(_metrics.minGap, follower->gap());
+      _gapSum += follower->gap();
+      _gapCount++;
+    }
+
+    _velocitySum += follower->velocity();
+    _velocityCount++;
+  }
+
+  _updateTimeSum += _timing.updateTime;
+
+  _metrics.simTime = _scheduler.currentTime();
+  _metrics.tickNum = _scheduler.tick();
+  _metrics.updateCount = _scheduler.updateCount();
+  _metrics.meanGap = (_gapCount > 0) ? _gapSum / _gapCount : 0.0;
+  _metrics.meanVelocity = (_velocityCount > 0) ? _velocitySum / _velocityCount : 0.0;
+  _metrics.updateTime = _updateTimeSum / _frame;
+  _metrics.meanDeviation = (_deviationCount > 0) ? _deviationSum / _deviationCount : 0.0;
+}
+
+void Simulation::publishTelemetry(float renderTime)
+{
+  if (!_telemetry.isOpen())
+  {
+    return;
+  }
+
+  _timing.renderTime = renderTime;
+
+  // Stream the states with the same IDs as V2V bus
+  _telemetry.beginFrame(static_cast<uint32_t>(_scheduler.tick()), _scheduler.currentTime(), _timing);
+  for (unsigned int i = 0; i < _cars.size(); i++)
+  {
+    _telemetry.addVehicle(i, *_cars.at(i));
+  }
+  _telemetry.endFrame();
+}
+
+void Simulation::run()
+{
+  while (!isFinished())
+  {
+    step();
+    publishTelemetry(0.0f);
+  }
+
+  _recorder.close();
+  updateMemoryMetrics();
+
+  if (!_scenario.metricsFile.empty())
+  {
+    writeMetrics(_scenario.metricsFile);
+  }
+}
+
+bool Simulation::applyManeuver(const Scenario::ManeuverConfig &maneuver)
+{
+  unsigned int leaderNum = _egoCars.size();
+  if (maneuver.vehicle < static_cast<int>(leaderNum) || maneuver.vehicle >= static_cast<int>(_cars.size()))
+  {
+    return false;
+  }
+
+  unsigned int id = maneuver.vehicle;
+  SimCar *follower = _followers.at(id - leaderNum).get();
+
+  if (maneuver.leader >= 0 && maneuver.leader < static_cast<int>(_cars.size()) && maneuver.leader != maneuver.vehicle)
+  {
+    // Only this follower is touched, others keep following their leading cars
+    follower->setLeadingCar(_cars.at(maneuver.leader));
+    follower->setV2VBus(&_bus, id, maneuver.leader);
+    _scheduler.setLeader(id, maneuver.leader);
+  }
+
+  if (maneuver.lane >= 0 && !_roads.empty())
+  {
+    follower->setLane(maneuver.lane);
+    _scheduler.wake(id);
+  }
+
+  return true;
+}
+
+bool Simulation::fail(const string &message)
+{
+  _error = message;
+  cout << message << endl;
+
+  return false;
+}
+
+bool Simulation::isFinished() const
+{
+  return _scheduler.currentTime() >= _endTime - _scenario.period * 0.5;
+}
+
+void Simulation::getMemoryUsage(MemoryReport *out_report) const
+{
+  for (const auto &egoCar : _egoCars)
+  {
+    out_report->add("car objects", egoCar.objectSize());
+    out_report->add("INS data", egoCar.dataMemoryUsage());
+    out_report->add("Kalman filter", egoCar.kalmanMemoryUsage());
+  }
+
+  for (const auto &follower : _followers)
+  {
+    out_report->add("car objects", follower->objectSize());
+    out_report->add("path histories", follower->historyMemoryUsage());
+  }
+
+  for (const auto &path : _paths)
+  {
+    out_report->add("whole paths", path.capacity() * sizeof(Car::PositionData));
+  }
+
+  for (const auto &path : _lanePaths)
+  {
+    out_report->add("whole paths", path.capacity() * sizeof(Car::PositionData));
+  }
+
+  for (const auto &road : _roads)
+  {
+    out_report->add("roads", road.memoryUsage());
+  }
+
+  out_report->add("V2V bus", _bus.memoryUsage());
+  out_report->add("scheduler", _scheduler.memoryUsage());
+  out_report->add("telemetry", _telemetry.memoryUsage());
+
+  if (_reference)
+  {
+    MemoryReport reference;
+    _reference->getMemoryUsage(&reference);
+    out_report->add("reference run", reference.total());
+  }
+}
+
+void Simulation::updateMemoryMetrics()
+{
+  MemoryReport report;
+  getMemoryUsage(&report);
+
+  _metrics.memoryBytes = report.total();
+}
+
+bool Simulation::writeMetrics(const string &filepath) const
+{
+  ConfigFile file;
+  ConfigFile::Section &section = file.addSection("");
+
+  auto add = [&](const string &key, double value) {
+    ostringstream stream;
+    stream.precision(9);
+    stream << value;
+    section.entries.push_back(ConfigFile::Entry(key, stream.str()));
+  };
+
+  add("sim_time", _metrics.simTime);
+  add("ticks", _metrics.tickNum);
+  add("updates", _metrics.updateCount);
+  add("min_gap", _metrics.minGap);
+  add("mean_gap", _metrics.meanGap);
+  add("mean_velocity", _metrics.meanVelocity);
+  add("update_time_ms", _metrics.updateTime);
+  add("memory_bytes", _metrics.memoryBytes);
+  add("max_deviation", _metrics.maxDeviation);
+  add("mean_deviation", _metrics.meanDeviation);
+
+  return file.save(filepath);
+}
@@ -0,0 +1,182 @@
+/**
+ * @file Simulation.hpp
+ * @author @jonatechout
+ * @brief Builds the cars of a scenario and runs them, with or without visualization.
+ */
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scenario.hpp"
+#include "MemoryReport.hpp"
+#include "PlaybackCar.hpp"
+#include "SimCar.hpp"
+#include "RoadModel.hpp"
+#include "V2VBus.hpp"
+#include "EventScheduler.hpp"
+#include "TelemetryServer.hpp"
+#include "TrajectoryRecorder.hpp"
+
+/**
+ * @class Simulation
+ * @brief Builds the cars of a scenario and runs them, with or without visualization.
+ * Vehicle IDs (V2V bus, telemetry and recording) are: ego cars first, then followers of each ego car in order.
+ * With a reference sub-step in the scenario, the same scenario also runs with RK4 at that sub-step
+ * and the distance of each follower from its reference position is measured every period.
+ */
+class Simulation
+{
+public:
+  struct Metrics
+  {
+    double simTime;                 ///< Simulated time [s]
+    unsigned long long tickNum;     ///< Number of ticks
+    unsigned long long updateCount; ///< Number of car updates
+    double minGap;                  ///< Minimum gap between a moving follower and its leading car [m] (-1: none)
+    double meanGap;                 ///< Mean gap between a moving follower and its leading car [m]
+    double meanVelocity;            ///< Mean velocity of followers [m/s]
+    double updateTime;              ///< Mean wall time to update the cars per tick [ms]
+    unsigned long long memoryBytes; ///< Memory footprint of all the subsystems [bytes] (see getMemoryUsage)
+    double maxDeviation;            ///< Maximum distance of a follower from the reference run [m] (0: no reference)
+    double meanDeviation;           ///< Mean distance of followers from the reference run [m]
+  };
+
+  Simulation();
+  virtual ~Simulation();
+
+  /**
+   * @brief Load INS data and build the cars of a scenario.
+   *
+   * @param scenario
+   * @param enableSinks Open the output sinks (record, telemetry) of the scenario
+   * @return true  Ready to run.
+   * @return false  Failed to load data, unknown controller or failed to open a sink.
+   */
+  bool init(const Scenario &scenario, bool enableSinks);
+
+  /**
+   * @brief Advance one period and record the frame.
+   */
+  void step();
+
+  /**
+   * @brief Send the current frame to telemetry clients.
+   *
+   * @param renderTime Wall time to render the frame [ms]
+   */
+  void publishTelemetry(float renderTime);
+
+  /**
+   * @brief Run until the end of the scenario without visualization.
+   */
+  void run();
+
+  /**
+   * @brief Returns true if the duration of the scenario has passed.
+   */
+  bool isFinished() const;
+
+  /**
+   * @brief Count bytes of each subsystem.
+   *
+   * @param out_report Entries are added to the report
+   */
+  void getMemoryUsage(MemoryReport *out_report) const;
+
+  /**
+   * @brief Update the memory footprint in the metrics (done at the end of run()).
+   */
+  void updateMemoryMetrics();
+
+  /**
+   * @brief Write the metrics as "key = value" file.
+   *
+   * @param filepath
+   * @return true  File is written.
+   * @return false  Failed to write.
+   */
+  bool writeMetrics(const std::string &filepath) const;
+
+  /**
+   * @brief Change the leading car and/or lane of a follower.
+   *
+   * @param maneuver
+   * @return true  Maneuver is applied.
+   * @return false  Wrong vehicle, leading car or lane.
+   */
+  bool applyManeuver(const Scenario::ManeuverConfig &maneuver);
+
+  /**
+   * @brief Create a following car of given controller.
+   *
+   * @param controller Name of controller (linear, idm, cacc)
+   * @return SimCar* New car (nullptr: unknown controller)
+   */
+  static SimCar *createFollower(const std::string &controller);
+
+  /**
+   * @brief Create the following cars of a leader with their controllers and parameters.
+   *
+   * @param scenario
+   * @param leaderIndex Index of the leader in the scenario
+   * @param out_followers Following cars, the first one follows the leader
+   * @param out_error Reason of failure
+   * @return true  All the followers are created.
+   * @return false  Unknown controller, parameter or integrator.
+   */
+  static bool createFollowers(const Scenario &scenario, unsigned int leaderIndex,
+                              std::vector<std::unique_ptr<SimCar> > *out_followers, std::string *out_error);
+
+  const Scenario &scenario() const { return _scenario; }
+  const std::string &error() const { return _error; } ///< Reason why init() failed
+  const Metrics &metrics() const { return _metrics; }
+  const std::vector<const Car *> &cars() const { return _cars; }
+  const std::vector<std::vector<Car::PositionData> > &paths() const { return _paths; }
+  const std::vector<std::vector<Car::PositionData> > &lanePaths() const { return _lanePaths; }
+  const Car &egoCar(unsigned int index) const { return _egoCars.at(index); }
+  unsigned int egoCarNum() const { return _egoCars.size(); }
+  unsigned int egoIndex(unsigned int id) const { return _roadIndices.at(id); } ///< Ego car which a vehicle started with
+  double currentTime() const { return _scheduler.currentTime(); }
+
+protected:
+  /**
+   * @brief Keep and print the reason of a failure.
+   *
+   * @param message
+   * @return false  Always, to be returned by the caller.
+   */
+  bool fail(const std::string &message);
+
+  Scenario _scenario;                              ///< Scenario to run
+  std::vector<PlaybackCar> _egoCars;               ///< Cars playing INS data
+  std::vector<std::unique_ptr<SimCar> > _followers; ///< Following cars of all the ego cars
+  std::vector<const Car *> _cars;                  ///< All the cars in the order of vehicle IDs
+  std::vector<std::vector<Car::PositionData> > _paths; ///< Whole path of each ego car (thinned out)
+  std::vector<std::vector<Car::PositionData> > _lanePaths; ///< Center lines of the lanes beside the paths
+  std::vector<RoadModel> _roads;                   ///< Road along the path of each ego car (empty: single lane)
+  std::vector<unsigned int> _roadIndices;          ///< Index of the ego car of each vehicle
+  unsigned int _nextManeuver;                      ///< Index of the next maneuver of the scenario
+
+  V2VBus _bus;                   ///< V2V bus between the cars
+  EventScheduler _scheduler;     ///< Updates the cars
+  TelemetryServer _telemetry;    ///< Telemetry sink
+  TrajectoryRecorder _recorder;  ///< Recording sink
+  double _endTime;               ///< Time to finish [s]
+  long long _frame;              ///< Number of steps
+
+  Metrics _metrics;                        ///< Metrics so far
+  TelemetryServer::TimingCounters _timing; ///< Timing of the last step
+  double _gapSum;                          ///< Sum of gaps for the mean
+  unsigned long long _gapCount;            ///< Number of gaps for the mean
+  double _velocitySum;                     ///< Sum of velocities for the mean
+  unsigned long long _velocityCount;       ///< Number of velocities for the mean
+  double _updateTimeSum;                   ///< Sum of update time [ms]
+  double _deviationSum;                    ///< Sum of deviations from the reference run [m]
+  unsigned long long _deviationCount;      ///< Number of deviations for the mean
+  std::unique_ptr<Simulation> _reference;  ///< Same scenario with fine-step integration (nullptr: no reference)
+  std::string _error;                      ///< Reason why init() failed
+};
+
+#endif
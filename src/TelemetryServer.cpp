@@ -0,0 +1,347 @@
+/**
+ * @file TelemetryServer.cpp
+ * @author @jonatechout
+ * @brief Streams vehicle states and timing counters to external dashboards over a local socket.
+ */
+#include "TelemetryServer.hpp"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <iostream>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using namespace std;
+
+const uint32_t TelemetryServer::magic;
+const uint16_t TelemetryServer::version;
+
+namespace
+{
+bool setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+template <class T>
+void append(vector<char> *out_buffer, const T &value)
+{
+  const char *p = reinterpret_cast<const char *>(&value);
+  out_buffer->insert(out_buffer->end(), p, p + sizeof(T));
+}
+}
+
+TelemetryServer::TelemetryServer() : _listenFd(-1),
+                                     _socketPath(),
+                                     _batchSize(5),
+                                     _maxPendingSize(1 << 20),
+                                     _clients(),
+                                     _batch(),
+                                     _frameNum(0),
+                                     _frameOffset(0),
+                                     _inFrame(false)
+{
+}
+
+TelemetryServer::~TelemetryServer()
+{
+  close();
+}
+
+bool TelemetryServer::open(const string &endpoint)
+{
+  const int backlog = 4; //Number of pending connections
+
+  close();
+
+  char *end = nullptr;
+  long port = strtol(endpoint.c_str(), &end, 10);
+  bool isTcp = !endpoint.empty() && *end == '\0';
+
+  if (isTcp)
+  {
+    if (port <= 0 || port > 65535)
+    {
+      cout << "Wrong telemetry port: " << endpoint << endl;
+      return false;
+    }
+
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0)
+    {
+      cout << "Failed to create telemetry socket: " << strerror(errno) << endl;
+      return false;
+    }
+
+    int reuse = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Local clients only
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+      cout << "Failed to bind telemetry port " << port << ": " << strerror(errno) << endl;
+      close();
+      return false;
+    }
+  }
+  else
+  {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (endpoint.empty() || endpoint.size() >= sizeof(addr.sun_path))
+    {
+      cout << "Wrong telemetry socket path: " << endpoint << endl;
+      return false;
+    }
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0)
+    {
+      cout << "Failed to create telemetry socket: " << strerror(errno) << endl;
+      return false;
+    }
+
+    // Remove the socket left by previous run
+    unlink(endpoint.c_str());
+    strncpy(addr.sun_path, endpoint.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (bind(_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+      cout << "Failed to bind telemetry socket " << endpoint << ": " << strerror(errno) << endl;
+      close();
+      return false;
+    }
+
+    _socketPath = endpoint;
+  }
+
+  if (listen(_listenFd, backlog) != 0 || !setNonBlocking(_listenFd))
+  {
+    cout << "Failed to listen telemetry socket: " << strerror(errno) << endl;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+size_t TelemetryServer::memoryUsage() const
+{
+  size_t bytes = _batch.capacity() + _clients.capacity() * sizeof(Client);
+  for (const auto &client : _clients)
+  {
+    bytes += client.pending.capacity();
+  }
+
+  return bytes;
+}
+
+void TelemetryServer::close()
+{
+  for (auto &client : _clients)
+  {
+    ::close(client.fd);
+  }
+  _clients.clear();
+
+  if (_listenFd >= 0)
+  {
+    ::close(_listenFd);
+    _listenFd = -1;
+  }
+
+  if (!_socketPath.empty())
+  {
+    unlink(_socketPath.c_str());
+    _socketPath.clear();
+  }
+
+  _batch.clear();
+  _frameNum = 0;
+  _inFrame = false;
+}
+
+void TelemetryServer::setBatchSize(unsigned int frameNum)
+{
+  _batchSize = max(frameNum, 1u);
+}
+
+void TelemetryServer::setMaxPendingSize(size_t size)
+{
+  _maxPendingSize = size;
+}
+
+void TelemetryServer::beginFrame(uint32_t tick, double time, const TimingCounters &timing)
+{
+  _inFrame = false;
+
+  if (_listenFd < 0)
+  {
+    return;
+  }
+
+  acceptClients();
+
+  if (_clients.empty())
+  {
+    // Nobody is listening, do not spend time on building frames
+    _batch.clear();
+    _frameNum = 0;
+    return;
+  }
+
+  if (_frameNum == 0)
+  {
+    _batch.clear();
+    append(&_batch, BatchHeader());
+  }
+
+  FrameHeader header;
+  header.tick = tick;
+  header.time = static_cast<float>(time);
+  header.updateTime = timing.updateTime;
+  header.renderTime = timing.renderTime;
+  header.updateCount = timing.updateCount;
+  header.vehicleNum = 0;
+
+  _frameOffset = _batch.size();
+  append(&_batch, header);
+  _inFrame = true;
+}
+
+void TelemetryServer::addVehicle(uint32_t id, const Car &car)
+{
+  if (!_inFrame)
+  {
+    return;
+  }
+
+  VehicleRecord rec;
+  rec.id = id;
+  rec.x = static_cast<float>(car.x());
+  rec.y = static_cast<float>(car.y());
+  rec.velocity = static_cast<float>(car.velocity());
+  rec.heading = static_cast<float>(car.heading());
+
+  append(&_batch, rec);
+
+  FrameHeader *header = reinterpret_cast<FrameHeader *>(&_batch.at(_frameOffset));
+  header->vehicleNum++;
+}
+
+void TelemetryServer::endFrame()
+{
+  if (!_inFrame)
+  {
+    return;
+  }
+
+  _inFrame = false;
+  _frameNum++;
+
+  if (_frameNum >= _batchSize)
+  {
+    BatchHeader header;
+    header.magic = magic;
+    header.version = version;
+    header.frameNum = static_cast<uint16_t>(_frameNum);
+    header.size = static_cast<uint32_t>(_batch.size() - sizeof(BatchHeader));
+    memcpy(&_batch.at(0), &header, sizeof(header));
+
+    for (auto &client : _clients)
+    {
+      client.pending.insert(client.pending.end(), _batch.begin(), _batch.end());
+    }
+
+    _batch.clear();
+    _frameNum = 0;
+  }
+
+  flushClients();
+}
+
+void TelemetryServer::acceptClients()
+{
+  while (1)
+  {
+    int fd = accept(_listenFd, nullptr, nullptr);
+    if (fd < 0)
+    {
+      // EAGAIN: no more pending connections
+      return;
+    }
+
+    if (!setNonBlocking(fd))
+    {
+      ::close(fd);
+      continue;
+    }
+
+    Client client;
+    client.fd = fd;
+    _clients.push_back(client);
+
+    cout << "Telemetry client connected (" << _clients.size() << " clients)" << endl;
+  }
+}
+
+void TelemetryServer::flushClients()
+{
+  for (auto it = _clients.begin(); it != _clients.end();)
+  {
+    Client &client = *it;
+    bool drop = false;
+
+    while (!client.pending.empty())
+    {
+      ssize_t sent = send(client.fd, client.pending.data(), client.pending.size(), MSG_NOSIGNAL);
+      if (sent > 0)
+      {
+        client.pending.erase(client.pending.begin(), client.pending.begin() + sent);
+        continue;
+      }
+
+      // EAGAIN: socket buffer is full, try again in the next frame
+      if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        cout << "Telemetry client disconnected" << endl;
+        drop = true;
+      }
+      break;
+    }
+
+    if (!drop && client.pending.size() > _maxPendingSize)
+    {
+      cout << "Telemetry client is too slow, dropped" << endl;
+      drop = true;
+    }
+
+    if (drop)
+    {
+      ::close(client.fd);
+      it = _clients.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file TelemetryServer.hpp
+ * @author @jonatechout
+ * @brief Streams vehicle states and timing counters to external dashboards over a local socket.
+ */
+#ifndef TELEMETRYSERVER_H
+#define TELEMETRYSERVER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Car.hpp"
+
+/**
+ * @class TelemetryServer
+ * @brief Streams vehicle states and timing counters to external dashboards over a local socket.
+ * Listens on a Unix domain socket or localhost TCP, and never blocks the simulation loop:
+ * clients are accepted and written without blocking, and a client which cannot keep up
+ * (too much data pending) is dropped.
+ *
+ * Frames are sent in batches. All the values are in host byte order.
+ *  - BatchHeader, followed by frameNum frames
+ *  - Frame: FrameHeader, followed by vehicleNum VehicleRecord
+ */
+class TelemetryServer
+{
+public:
+  static const uint32_t magic = 0x4d544c50; ///< "PLTM"
+  static const uint16_t version = 1;        ///< Version of the framing
+
+  struct BatchHeader
+  {
+    uint32_t magic;    ///< TelemetryServer::magic
+    uint16_t version;  ///< TelemetryServer::version
+    uint16_t frameNum; ///< Number of frames in the batch
+    uint32_t size;     ///< Size of the frames following this header [byte]
+  };
+
+  struct FrameHeader
+  {
+    uint32_t tick;        ///< Simulation tick
+    float time;           ///< Simulation time [s]
+    float updateTime;     ///< Wall time to update the cars [ms]
+    float renderTime;     ///< Wall time to render the image [ms]
+    uint32_t updateCount; ///< Number of car updates in this frame
+    uint32_t vehicleNum;  ///< Number of vehicles following this header
+  };
+
+  struct VehicleRecord
+  {
+    uint32_t id;    ///< Vehicle ID (same as V2V bus)
+    float x;        ///< X [m]
+    float y;        ///< Y [m]
+    float velocity; ///< Velocity [m/s]
+    float heading;  ///< Heading angle [rad]
+  };
+
+  struct TimingCounters
+  {
+    float updateTime;     ///< Wall time to update the cars [ms]
+    float renderTime;     ///< Wall time to render the image [ms]
+    uint32_t updateCount; ///< Number of car updates in this frame
+  };
+
+  TelemetryServer();
+  virtual ~TelemetryServer();
+
+  /**
+   * @brief Start listening.
+   *
+   * @param endpoint TCP port number on localhost, or path of Unix domain socket
+   * @return true  Listening.
+   * @return false  Failed to open the socket.
+   */
+  bool open(const std::string &endpoint);
+
+  /**
+   * @brief Disconnect all the clients and stop listening.
+   */
+  void close();
+
+  /**
+   * @brief Set the number of frames sent at once.
+   *
+   * @param frameNum Number of frames per batch
+   */
+  void setBatchSize(unsigned int frameNum);
+
+  /**
+   * @brief Set the size of data pending for a client to drop it.
+   *
+   * @param size [byte]
+   */
+  void setMaxPendingSize(size_t size);
+
+  /**
+   * @brief Accept new clients and start a frame. Vehicles are only recorded if a client is connected.
+   *
+   * @param tick Simulation tick
+   * @param time Simulation time [s]
+   * @param timing Timing counters of this frame
+   */
+  void beginFrame(uint32_t tick, double time, const TimingCounters &timing);
+
+  /**
+   * @brief Add a vehicle state to the current frame.
+   *
+   * @param id Vehicle ID
+   * @param car
+   */
+  void addVehicle(uint32_t id, const Car &car);
+
+  /**
+   * @brief Finish the current frame. Sends the batch if it is full.
+   */
+  void endFrame();
+
+  /**
+   * @brief Returns bytes of the batch being built and data not sent to clients.
+   */
+  size_t memoryUsage() const;
+
+  bool isOpen() const { return _listenFd >= 0; }
+  unsigned int clientNum() const { return _clients.size(); }
+
+protected:
+  struct Client
+  {
+    int fd;                    ///< Socket
+    std::vector<char> pending; ///< Data not sent yet
+  };
+
+  /**
+   * @brief Accept all the pending connections.
+   */
+  void acceptClients();
+
+  /**
+   * @brief Send pending data of clients, and drop the clients which are too slow or disconnected.
+   */
+  void flushClients();
+
+  int _listenFd;            ///< Listening socket (-1: closed)
+  std::string _socketPath;  ///< Path of Unix domain socket (empty: TCP)
+  unsigned int _batchSize;  ///< Number of frames per batch
+  size_t _maxPendingSize;   ///< Size of pending data to drop a client [byte]
+
+  std::vector<Client> _clients; ///< Connected clients
+  std::vector<char> _batch;     ///< Batch being built (header + frames)
+  unsigned int _frameNum;       ///< Number of frames in the batch
+  size_t _frameOffset;          ///< Offset of the current frame header in _batch
+  bool _inFrame;                ///< True if recording the current frame
+};
+
+#endif
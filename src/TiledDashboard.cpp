@@ -0,0 +1,151 @@
+/**
+ * @file TiledDashboard.cpp
+ * @author @jonatechout
+ * @brief Overview image of many platoons, one viewport per platoon rendered in parallel.
+ */
+#include "TiledDashboard.hpp"
+#include <algorithm>
+
+using namespace std;
+
+TiledDashboard::TiledDashboard() : _threadNum(0),
+                                   _frameCount(0),
+                                   _busyWorkerNum(0),
+                                   _stopping(false),
+                                   _nextTile(0)
+{
+}
+
+TiledDashboard::~TiledDashboard()
+{
+  stopWorkers();
+}
+
+void TiledDashboard::setThreadNum(unsigned int threadNum)
+{
+  _threadNum = threadNum;
+}
+
+void TiledDashboard::init(unsigned int tileNum, unsigned int columnNum, int tileSizeX, int tileSizeY, double scale)
+{
+  stopWorkers();
+
+  columnNum = max(min(columnNum, tileNum), 1u);
+  unsigned int rowNum = (tileNum + columnNum - 1) / columnNum;
+
+  _frame = cv::Mat::zeros(cv::Size(columnNum * tileSizeX, max(rowNum, 1u) * tileSizeY), CV_8UC3);
+
+  _tiles = vector<Visualizer>(tileNum);
+  _tileImages.clear();
+  for (unsigned int i = 0; i < tileNum; i++)
+  {
+    _tiles.at(i).init(tileSizeX, tileSizeY, tileSizeX / 2, tileSizeY / 2, scale);
+
+    cv::Rect region((i % columnNum) * tileSizeX, (i / columnNum) * tileSizeY, tileSizeX, tileSizeY);
+    _tileImages.push_back(_frame(region));
+  }
+
+  // The calling thread renders too, so one less worker is needed
+  unsigned int threadNum = (_threadNum > 0) ? _threadNum : max(thread::hardware_concurrency(), 1u);
+  threadNum = max(min(threadNum, tileNum), 1u);
+
+  _stopping = false;
+  _frameCount = 0;
+  for (unsigned int i = 1; i < threadNum; i++)
+  {
+    _workers.push_back(thread(&TiledDashboard::workerLoop, this));
+  }
+}
+
+void TiledDashboard::getImage(cv::Mat *out_img)
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _nextTile.store(0);
+    _busyWorkerNum = _workers.size();
+    _frameCount++;
+  }
+  _frameStarted.notify_all();
+
+  renderTiles();
+
+  // The only synchronization of the frame: wait for the workers to finish their last tiles
+  {
+    unique_lock<mutex> lock(_mutex);
+    _frameDone.wait(lock, [this]() { return _busyWorkerNum == 0; });
+  }
+
+  (*out_img) = _frame;
+}
+
+size_t TiledDashboard::memoryUsage() const
+{
+  size_t bytes = _frame.total() * _frame.elemSize();
+  for (const auto &tile : _tiles)
+  {
+    bytes += tile.memoryUsage();
+  }
+
+  return bytes;
+}
+
+void TiledDashboard::workerLoop()
+{
+  unsigned long long lastFrame = 0;
+
+  while (true)
+  {
+    {
+      unique_lock<mutex> lock(_mutex);
+      _frameStarted.wait(lock, [&]() { return _stopping || _frameCount != lastFrame; });
+
+      if (_stopping)
+      {
+        return;
+      }
+
+      lastFrame = _frameCount;
+    }
+
+    renderTiles();
+
+    {
+      lock_guard<mutex> lock(_mutex);
+      _busyWorkerNum--;
+      if (_busyWorkerNum == 0)
+      {
+        _frameDone.notify_one();
+      }
+    }
+  }
+}
+
+void TiledDashboard::renderTiles()
+{
+  unsigned int index;
+  while ((index = _nextTile.fetch_add(1)) < _tiles.size())
+  {
+    cv::Mat &image = _tileImages.at(index);
+    _tiles.at(index).drawImage(&image);
+
+    // Number of the platoon and border between tiles
+    cv::putText(image, to_string(index), cv::Point2d(5, 15), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255));
+    cv::rectangle(image, cv::Point2d(0, 0), cv::Point2d(image.cols - 1, image.rows - 1), cv::Scalar(120, 120, 120));
+  }
+}
+
+void TiledDashboard::stopWorkers()
+{
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _frameStarted.notify_all();
+
+  for (auto &worker : _workers)
+  {
+    worker.join();
+  }
+
+  _workers.clear();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file TiledDashboard.hpp
+ * @author @jonatechout
+ * @brief Overview image of many platoons, one viewport per platoon rendered in parallel.
+ */
+#ifndef TILEDDASHBOARD_H
+#define TILEDDASHBOARD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Visualizer.hpp"
+
+/**
+ * @class TiledDashboard
+ * @brief Overview image of many platoons, one viewport per platoon rendered in parallel.
+ * Each tile is a Visualizer which draws into its own region of a shared frame, so tiles never touch the same pixels.
+ * Worker threads are kept for the lifetime of the dashboard and are synchronized once per frame:
+ * getImage() starts a frame, renders tiles together with the workers and returns when all the tiles are drawn.
+ * Tiles must not be changed while getImage() is running.
+ */
+class TiledDashboard
+{
+public:
+  TiledDashboard();
+  virtual ~TiledDashboard();
+
+  /**
+   * @brief Set the number of threads. Must be called before init().
+   *
+   * @param threadNum Number of threads including the calling thread (0: number of hardware threads)
+   */
+  void setThreadNum(unsigned int threadNum);
+
+  /**
+   * @brief Initialize tiles and start worker threads.
+   *
+   * @param tileNum Number of tiles
+   * @param columnNum Number of tiles in a row
+   * @param tileSizeX Tile size x [pix]
+   * @param tileSizeY Tile size y [pix]
+   * @param scale Scale factor of each tile
+   */
+  void init(unsigned int tileNum, unsigned int columnNum, int tileSizeX, int tileSizeY, double scale);
+
+  /**
+   * @brief Render all the tiles and get the frame.
+   * The frame shares the buffer of the dashboard, it is overwritten by the next call.
+   *
+   * @param out_img output image
+   */
+  void getImage(cv::Mat *out_img);
+
+  /**
+   * @brief Returns bytes of the frame and the objects and lines of all the tiles.
+   */
+  size_t memoryUsage() const;
+
+  Visualizer &tile(unsigned int index) { return _tiles.at(index); }
+  unsigned int tileNum() const { return _tiles.size(); }
+
+protected:
+  /**
+   * @brief Wait for frames and render tiles until stopped.
+   */
+  void workerLoop();
+
+  /**
+   * @brief Render the next tile which is not taken until all the tiles of the frame are taken.
+   */
+  void renderTiles();
+
+  /**
+   * @brief Stop and join worker threads.
+   */
+  void stopWorkers();
+
+  std::vector<Visualizer> _tiles;    ///< Viewport of each tile
+  std::vector<cv::Mat> _tileImages;  ///< Region of each tile in the frame (shares the buffer of the frame)
+  cv::Mat _frame;                    ///< Frame of all the tiles
+
+  unsigned int _threadNum;               ///< Number of threads (0: number of hardware threads)
+  std::vector<std::thread> _workers;     ///< Worker threads (the calling thread also renders)
+  std::mutex _mutex;                     ///< Guards the frame state below
+  std::condition_variable _frameStarted; ///< Notified when a frame starts or workers stop
+  std::condition_variable _frameDone;    ///< Notified when the last worker finishes a frame
+  unsigned long long _frameCount;        ///< Number of frames started
+  unsigned int _busyWorkerNum;           ///< Number of workers which have not finished the current frame
+  bool _stopping;                        ///< True to stop workers
+  std::atomic<unsigned int> _nextTile;   ///< Next tile to render in the current frame
+};
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file TrajectoryFormat.hpp
+ * @author @jonatechout
+ * @brief Layout of recorded trajectory files.
+ */
+#ifndef TRAJECTORYFORMAT_H
+#define TRAJECTORYFORMAT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Layout of recorded trajectory files. All the values are in host byte order.
+ *  - FileHeader
+ *  - Number of points of each path (uint32_t x pathNum)
+ *  - Path points (PathPoint x pathPointNum)
+ *  - Frames from dataOffset, each frame is FrameHeader followed by vehicleNum VehicleState
+ * Every frame has the same size, so frame i is found at dataOffset + i * frameSize.
+ */
+namespace TrajectoryFormat
+{
+const char magic[8] = {'P', 'L', 'T', 'T', 'R', 'A', 'J', '\0'};
+const uint32_t version = 2;
+
+struct FileHeader
+{
+  char magic[8];         ///< TrajectoryFormat::magic
+  uint32_t version;      ///< TrajectoryFormat::version
+  uint32_t vehicleNum;   ///< Number of vehicles in a frame
+  uint32_t pathNum;      ///< Number of paths
+  uint32_t pathPointNum; ///< Total number of path points
+  double period;         ///< Time between frames [s]
+  uint64_t dataOffset;   ///< Offset of the first frame [byte]
+  int32_t windowWidth;   ///< Window width of the recorded scenario [pix]
+  int32_t windowHeight;  ///< Window height of the recorded scenario [pix]
+  double scale;          ///< Scale factor of the recorded scenario
+};
+
+struct PathPoint
+{
+  double x; ///< X [m] (world coordinate)
+  double y; ///< Y [m] (world coordinate)
+};
+
+struct FrameHeader
+{
+  double time; ///< Simulation time [s]
+};
+
+struct VehicleState
+{
+  double x;       ///< X [m] (world coordinate)
+  double y;       ///< Y [m] (world coordinate)
+  float velocity; ///< Velocity [m/s]
+  float heading;  ///< Heading angle [rad]
+};
+
+/**
+ * @brief Returns the size of a frame [byte]
+ */
+inline uint64_t frameSize(uint32_t vehicleNum)
+{
+  return sizeof(FrameHeader) + static_cast<uint64_t>(vehicleNum) * sizeof(VehicleState);
+}
+}
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file TrajectoryPlayer.cpp
+ * @author @jonatechout
+ * @brief Plays a recorded trajectory file without re-simulating.
+ */
+#include "TrajectoryPlayer.hpp"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <iostream>
+
+using namespace std;
+
+TrajectoryPlayer::TrajectoryPlayer() : _map(nullptr),
+                                       _mapSize(0),
+                                       _header(nullptr),
+                                       _frameNum(0)
+{
+}
+
+TrajectoryPlayer::~TrajectoryPlayer()
+{
+  close();
+}
+
+bool TrajectoryPlayer::open(const string &filepath)
+{
+  close();
+
+  int fd = ::open(filepath.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    cout << "Failed to open file: " << filepath << endl;
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TrajectoryFormat::FileHeader))
+  {
+    cout << "Wrong file format: " << filepath << endl;
+    ::close(fd);
+    return false;
+  }
+
+  _mapSize = st.st_size;
+  _map = mmap(nullptr, _mapSize, PROT_READ, MAP_SHARED, fd, 0);
+
+  // The mapping stays valid after closing the descriptor
+  ::close(fd);
+
+  if (_map == MAP_FAILED)
+  {
+    cout << "Failed to map file: " << filepath << endl;
+    _map = nullptr;
+    _mapSize = 0;
+    return false;
+  }
+
+  const TrajectoryFormat::FileHeader *header = static_cast<const TrajectoryFormat::FileHeader *>(_map);
+
+  uint64_t pathEnd = sizeof(TrajectoryFormat::FileHeader) + static_cast<uint64_t>(header->pathNum) * sizeof(uint32_t) +
+                     static_cast<uint64_t>(header->pathPointNum) * sizeof(TrajectoryFormat::PathPoint);
+
+  if (memcmp(header->magic, TrajectoryFormat::magic, sizeof(header->magic)) != 0 ||
+      header->version != TrajectoryFormat::version || header->vehicleNum == 0 || header->period <= 0.0 ||
+      header->windowWidth <= 0 || header->windowHeight <= 0 || header->scale <= 0.0 ||
+      header->dataOffset < pathEnd || header->dataOffset > _mapSize)
+  {
+    cout << "Wrong file format: " << filepath << endl;
+    close();
+    return false;
+  }
+
+  // Points of each path must add up to the total, otherwise paths would be read beyond the path table
+  const uint32_t *pointNums = reinterpret_cast<const uint32_t *>(static_cast<const char *>(_map) + sizeof(TrajectoryFormat::FileHeader));
+  uint64_t pointSum = 0;
+  for (unsigned int k = 0; k < header->pathNum; k++)
+  {
+    pointSum += pointNums[k];
+  }
+
+  if (pointSum != header->pathPointNum)
+  {
+    cout << "Wrong file format: " << filepath << endl;
+    close();
+    return false;
+  }
+
+  _header = header;
+
+  // The last frame of an interrupted recording may be incomplete
+  _frameNum = (_mapSize - _header->dataOffset) / TrajectoryFormat::frameSize(_header->vehicleNum);
+
+  return true;
+}
+
+void TrajectoryPlayer::close()
+{
+  if (_map != nullptr)
+  {
+    munmap(_map, _mapSize);
+  }
+
+  _map = nullptr;
+  _mapSize = 0;
+  _header = nullptr;
+  _frameNum = 0;
+}
+
+void TrajectoryPlayer::getPaths(vector<vector<Car::PositionData> > *out_paths) const
+{
+  out_paths->clear();
+
+  if (_header == nullptr)
+  {
+    return;
+  }
+
+  const char *base = static_cast<const char *>(_map);
+  const uint32_t *pointNums = reinterpret_cast<const uint32_t *>(base + sizeof(TrajectoryFormat::FileHeader));
+  const TrajectoryFormat::PathPoint *pnt = reinterpret_cast<const TrajectoryFormat::PathPoint *>(pointNums + _header->pathNum);
+
+  out_paths->resize(_header->pathNum);
+  for (unsigned int k = 0; k < _header->pathNum; k++)
+  {
+    vector<Car::PositionData> &path = out_paths->at(k);
+    path.reserve(pointNums[k]);
+
+    for (unsigned int i = 0; i < pointNums[k]; i++, pnt++)
+    {
+      Car::PositionData pos;
+      pos.timestamp = 0.0;
+      pos.x = pnt->x;
+      pos.y = pnt->y;
+      path.push_back(pos);
+    }
+  }
+}
+
+double TrajectoryPlayer::frameTime(unsigned long long index) const
+{
+  return reinterpret_cast<const TrajectoryFormat::FrameHeader *>(frame(index))->time;
+}
+
+const TrajectoryFormat::VehicleState *TrajectoryPlayer::vehicles(unsigned long long index) const
+{
+  return reinterpret_cast<const TrajectoryFormat::VehicleState *>(frame(index) + sizeof(TrajectoryFormat::FrameHeader));
+}
+
+const char *TrajectoryPlayer::frame(unsigned long long index) const
+{
+  return static_cast<const char *>(_map) + _header->dataOffset + index * TrajectoryFormat::frameSize(_header->vehicleNum);
+}
@@ -0,0 +1,84 @@
+/**
+ * @file TrajectoryPlayer.hpp
+ * @author @jonatechout
+ * @brief Plays a recorded trajectory file without re-simulating.
+ */
+#ifndef TRAJECTORYPLAYER_H
+#define TRAJECTORYPLAYER_H
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include "Car.hpp"
+#include "TrajectoryFormat.hpp"
+
+/**
+ * @class TrajectoryPlayer
+ * @brief Plays a recorded trajectory file without re-simulating.
+ * The file is memory-mapped and frames have a fixed size, so any frame is accessed in O(1)
+ * and only the pages of the frames actually shown are read from disk.
+ */
+class TrajectoryPlayer
+{
+public:
+  TrajectoryPlayer();
+  virtual ~TrajectoryPlayer();
+
+  /**
+   * @brief Map a trajectory file.
+   *
+   * @param filepath
+   * @return true  File is mapped.
+   * @return false  Failed to open or wrong file format.
+   */
+  bool open(const std::string &filepath);
+
+  /**
+   * @brief Unmap the file.
+   */
+  void close();
+
+  /**
+   * @brief Get the paths stored in the file.
+   *
+   * @param out_paths Paths (timestamps are 0)
+   */
+  void getPaths(std::vector<std::vector<Car::PositionData> > *out_paths) const;
+
+  /**
+   * @brief Returns the simulation time of a frame.
+   *
+   * @param index Frame index, must be less than frameNum()
+   * @return double [s]
+   */
+  double frameTime(unsigned long long index) const;
+
+  /**
+   * @brief Returns the vehicle states of a frame.
+   *
+   * @param index Frame index, must be less than frameNum()
+   * @return const TrajectoryFormat::VehicleState* Array of vehicleNum() states
+   */
+  const TrajectoryFormat::VehicleState *vehicles(unsigned long long index) const;
+
+  bool isOpen() const { return _header != nullptr; }
+  unsigned long long frameNum() const { return _frameNum; }
+  unsigned int vehicleNum() const { return _header->vehicleNum; }
+  double period() const { return _header->period; }
+  int windowWidth() const { return _header->windowWidth; }
+  int windowHeight() const { return _header->windowHeight; }
+  double scale() const { return _header->scale; }
+
+protected:
+  /**
+   * @brief Returns the address of a frame.
+   */
+  const char *frame(unsigned long long index) const;
+
+  void *_map;                                  ///< Mapped file (nullptr: not mapped)
+  size_t _mapSize;                             ///< Size of the mapped file [byte]
+  const TrajectoryFormat::FileHeader *_header; ///< Header in the mapped file
+  unsigned long long _frameNum;                ///< Number of complete frames
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file TrajectoryRecorder.cpp
+ * @author @jonatechout
+ * @brief Records the states of all the cars into a trajectory file for replay.
+ */
+#include "TrajectoryRecorder.hpp"
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+
+TrajectoryRecorder::TrajectoryRecorder() : _ofs(),
+                                           _vehicleNum(0),
+                                           _frameNum(0),
+                                           _frame()
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+  close();
+}
+
+bool TrajectoryRecorder::open(const string &filepath, unsigned int vehicleNum, double period, int windowWidth, int windowHeight,
+                              double scale, const vector<vector<Car::PositionData> > &paths)
+{
+  close();
+
+  _ofs.open(filepath.c_str(), ios::binary | ios::trunc);
+  if (_ofs.fail())
+  {
+    cout << "Failed to create file: " << filepath << endl;
+    return false;
+  }
+
+  vector<uint32_t> pointNums;
+  uint32_t pathPointNum = 0;
+  for (const auto &path : paths)
+  {
+    pointNums.push_back(path.size());
+    pathPointNum += path.size();
+  }
+
+  // Frames start at 8 byte boundary
+  uint64_t dataOffset = sizeof(TrajectoryFormat::FileHeader) + pointNums.size() * sizeof(uint32_t) +
+                        pathPointNum * sizeof(TrajectoryFormat::PathPoint);
+  uint64_t padding = (8 - dataOffset % 8) % 8;
+  dataOffset += padding;
+
+  TrajectoryFormat::FileHeader header;
+  memcpy(header.magic, TrajectoryFormat::magic, sizeof(header.magic));
+  header.version = TrajectoryFormat::version;
+  header.vehicleNum = vehicleNum;
+  header.pathNum = paths.size();
+  header.pathPointNum = pathPointNum;
+  header.period = period;
+  header.dataOffset = dataOffset;
+  header.windowWidth = windowWidth;
+  header.windowHeight = windowHeight;
+  header.scale = scale;
+
+  _ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  _ofs.write(reinterpret_cast<const char *>(pointNums.data()), pointNums.size() * sizeof(uint32_t));
+
+  for (const auto &path : paths)
+  {
+    for (const auto &pos : path)
+    {
+      TrajectoryFormat::PathPoint pnt;
+      pnt.x = pos.x;
+      pnt.y = pos.y;
+      _ofs.write(reinterpret_cast<const char *>(&pnt), sizeof(pnt));
+    }
+  }
+
+  const char zeros[8] = {0};
+  _ofs.write(zeros, padding);
+
+  _vehicleNum = vehicleNum;
+  _frameNum = 0;
+  _frame.resize(vehicleNum);
+
+  if (_ofs.fail())
+  {
+    cout << "Failed to write file: " << filepath << endl;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool TrajectoryRecorder::writeFrame(double time, const vector<const Car *> &cars)
+{
+  if (!_ofs.is_open() || cars.size() != _vehicleNum)
+  {
+    return false;
+  }
+
+  TrajectoryFormat::FrameHeader header;
+  header.time = time;
+
+  for (unsigned int i = 0; i < _vehicleNum; i++)
+  {
+    _frame.at(i).x = cars.at(i)->x();
+    _frame.at(i).y = cars.at(i)->y();
+    _frame.at(i).velocity = static_cast<float>(cars.at(i)->velocity());
+    _frame.at(i).heading = static_cast<float>(cars.at(i)->heading());
+  }
+
+  _ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  _ofs.write(reinterpret_cast<const char *>(_frame.data()), _frame.size() * sizeof(TrajectoryFormat::VehicleState));
+
+  if (_ofs.fail())
+  {
+    cout << "Failed to write trajectory frame" << endl;
+    close();
+    return false;
+  }
+
+  _frameNum++;
+
+  return true;
+}
+
+void TrajectoryRecorder::close()
+{
+  if (_ofs.is_open())
+  {
+    _ofs.close();
+  }
+  _ofs.clear();
+}
@@ -0,0 +1,68 @@
+/**
+ * @file TrajectoryRecorder.hpp
+ * @author @jonatechout
+ * @brief Records the states of all the cars into a trajectory file for replay.
+ */
+#ifndef TRAJECTORYRECORDER_H
+#define TRAJECTORYRECORDER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Car.hpp"
+#include "TrajectoryFormat.hpp"
+
+/**
+ * @class TrajectoryRecorder
+ * @brief Records the states of all the cars into a trajectory file for replay.
+ * See TrajectoryFormat for the layout. Frames are appended as they are recorded,
+ * so a file of an interrupted run can be replayed up to the last complete frame.
+ */
+class TrajectoryRecorder
+{
+public:
+  TrajectoryRecorder();
+  virtual ~TrajectoryRecorder();
+
+  /**
+   * @brief Create a trajectory file and write the header and paths.
+   *
+   * @param filepath
+   * @param vehicleNum Number of vehicles in a frame
+   * @param period Time between frames [s]
+   * @param windowWidth Window width to replay with [pix]
+   * @param windowHeight Window height to replay with [pix]
+   * @param scale Scale factor to replay with
+   * @param paths Paths to show in replay (e.g. whole paths of ego cars)
+   * @return true  File is created.
+   * @return false  Failed to create the file.
+   */
+  bool open(const std::string &filepath, unsigned int vehicleNum, double period, int windowWidth, int windowHeight,
+            double scale, const std::vector<std::vector<Car::PositionData> > &paths);
+
+  /**
+   * @brief Append a frame.
+   *
+   * @param time Simulation time [s]
+   * @param cars Cars to record, the number must be the same as given to open()
+   * @return true  Frame is written.
+   * @return false  File is not open, wrong number of cars or write error.
+   */
+  bool writeFrame(double time, const std::vector<const Car *> &cars);
+
+  /**
+   * @brief Flush and close the file.
+   */
+  void close();
+
+  bool isOpen() const { return _ofs.is_open(); }
+  unsigned long long frameNum() const { return _frameNum; }
+
+protected:
+  std::ofstream _ofs;                                ///< Output file
+  unsigned int _vehicleNum;                          ///< Number of vehicles in a frame
+  unsigned long long _frameNum;                      ///< Number of recorded frames
+  std::vector<TrajectoryFormat::VehicleState> _frame; ///< Buffer of a frame
+};
+
+#endif
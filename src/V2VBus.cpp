@@ -0,0 +1,222 @@
+/**
+ * @file V2VBus.cpp
+ * @author @jonatechout
+ * @brief Simulated vehicle-to-vehicle communication with latency, jitter and loss.
+ */
+#include "V2VBus.hpp"
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+uint64_t splitMix64(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+}
+
+V2VBus::V2VBus() : _latency(0.0),
+                   _jitter(0.0),
+                   _dropRate(0.0),
+                   _seed(0),
+                   _latencyTicks(0),
+                   _jitterTicks(0),
+                   _depth(2),
+                   _vehicleNum(0),
+                   _period(0.02),
+                   _tick(0),
+                   _mailboxes(),
+                   _publishers()
+{
+}
+
+V2VBus::~V2VBus()
+{
+}
+
+void V2VBus::setChannel(double latency, double jitter, double dropRate)
+{
+  _latency = max(latency, 0.0);
+  _jitter = max(jitter, 0.0);
+  _dropRate = min(max(dropRate, 0.0), 1.0);
+}
+
+void V2VBus::setSeed(uint64_t seed)
+{
+  _seed = seed;
+}
+
+void V2VBus::init(unsigned int vehicleNum, double period)
+{
+  _vehicleNum = vehicleNum;
+  _period = period;
+
+  _latencyTicks = static_cast<unsigned int>(floor(_latency / _period + 0.5));
+  _jitterTicks = static_cast<unsigned int>(floor(_jitter / _period + 0.5));
+
+  // Keep one spare mailbox so the message being written is never the one being read
+  _depth = _latencyTicks + _jitterTicks + 2;
+
+  _mailboxes.reset(new Mailbox[_vehicleNum * _depth]);
+  for (unsigned int i = 0; i < _vehicleNum * _depth; i++)
+  {
+    _mailboxes[i].sequence.store(0, memory_order_relaxed);
+  }
+
+  _publishers.reset(new PublisherState[_vehicleNum]);
+  for (unsigned int i = 0; i < _vehicleNum; i++)
+  {
+    _publishers[i].tick.store(0, memory_order_relaxed);
+    _publishers[i].velocity = 0.0f;
+  }
+
+  _tick.store(0, memory_order_release);
+}
+
+void V2VBus::advance()
+{
+  _tick.fetch_add(1, memory_order_acq_rel);
+}
+
+void V2VBus::advanceTo(unsigned int tick)
+{
+  _tick.store(tick, memory_order_release);
+}
+
+void V2VBus::publish(unsigned int senderId, const Car &car)
+{
+  if (senderId >= _vehicleNum)
+  {
+    return;
+  }
+
+  uint32_t currentTick = tick();
+  PublisherState &publisher = _publishers[senderId];
+  Mailbox &mailbox = _mailboxes[senderId * _depth + currentTick % _depth];
+
+  float velocity = static_cast<float>(car.velocity());
+  float accel = 0.0f;
+  uint32_t lastTick = publisher.tick.load(memory_order_relaxed);
+  if (lastTick != 0 && lastTick < currentTick)
+  {
+    // A vehicle which has not published was sleeping, its state was unchanged until the last tick
+    accel = (velocity - publisher.velocity) / static_cast<float>(_period);
+  }
+
+  // Mark as being written, write, then publish the sequence
+  mailbox.sequence.store(0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  mailbox.message.senderId = senderId;
+  mailbox.message.tick = currentTick;
+  mailbox.message.x = car.x();
+  mailbox.message.y = car.y();
+  mailbox.message.velocity = velocity;
+  mailbox.message.accel = accel;
+  mailbox.message.heading = static_cast<float>(car.heading());
+
+  mailbox.sequence.store(currentTick + 1, memory_order_release);
+
+  publisher.velocity = velocity;
+  publisher.tick.store(currentTick, memory_order_release);
+}
+
+bool V2VBus::receive(unsigned int senderId, unsigned int receiverId, StateMessage *out_message) const
+{
+  if (senderId >= _vehicleNum)
+  {
+    return false;
+  }
+
+  uint32_t currentTick = tick();
+  uint32_t lastTick = _publishers[senderId].tick.load(memory_order_acquire);
+
+  // Newest message which has arrived by now. Messages sent more than latency + jitter ago have arrived or are lost,
+  // and they are still in the mailboxes.
+  for (unsigned int age = _latencyTicks; age <= _latencyTicks + _jitterTicks && age <= currentTick; age++)
+  {
+    uint32_t sentTick = currentTick - age;
+    if (age < messageDelay(senderId, receiverId, sentTick) || isDropped(senderId, receiverId, sentTick))
+    {
+      continue;
+    }
+
+    if (readMailbox(senderId, sentTick, out_message))
+    {
+      return true;
+    }
+
+    // A vehicle which did not publish at a past tick was sleeping and repeats its last message.
+    // Its state was unchanged, so the repeated message has zero acceleration.
+    if (sentTick < currentTick && lastTick != 0 && lastTick < sentTick && readMailbox(senderId, lastTick, out_message))
+    {
+      out_message->tick = sentTick;
+      out_message->accel = 0.0f;
+      return true;
+    }
+
+    // A vehicle updated later in the current tick (e.g. after changing the leading car) has not published yet.
+    // Its message of the previous update is the newest one.
+    if (sentTick == currentTick && lastTick != 0 && lastTick < sentTick && readMailbox(senderId, lastTick, out_message))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+unsigned int V2VBus::messageDelay(unsigned int senderId, unsigned int receiverId, unsigned int sentTick) const
+{
+  const uint64_t saltDelay = 1;
+
+  if (_jitterTicks == 0)
+  {
+    return _latencyTicks;
+  }
+
+  return _latencyTicks + hash(senderId, receiverId, sentTick, saltDelay) % (_jitterTicks + 1);
+}
+
+bool V2VBus::isDropped(unsigned int senderId, unsigned int receiverId, unsigned int sentTick) const
+{
+  const uint64_t saltDrop = 2;
+
+  if (_dropRate <= 0.0)
+  {
+    return false;
+  }
+
+  // Upper 53 bits as uniform random number in [0, 1)
+  double r = static_cast<double>(hash(senderId, receiverId, sentTick, saltDrop) >> 11) * (1.0 / 9007199254740992.0);
+  return r < _dropRate;
+}
+
+bool V2VBus::readMailbox(unsigned int senderId, unsigned int tick, StateMessage *out_message) const
+{
+  const Mailbox &mailbox = _mailboxes[senderId * _depth + tick % _depth];
+
+  uint32_t sequence = mailbox.sequence.load(memory_order_acquire);
+  if (sequence != tick + 1)
+  {
+    return false;
+  }
+
+  *out_message = mailbox.message;
+
+  // The message must not have been overwritten while copying
+  atomic_thread_fence(memory_order_acquire);
+  return mailbox.sequence.load(memory_order_relaxed) == sequence;
+}
+
+uint64_t V2VBus::hash(unsigned int senderId, unsigned int receiverId, unsigned int tick, uint64_t salt) const
+{
+  uint64_t h = splitMix64(_seed ^ salt);
+  h = splitMix64(h ^ (static_cast<uint64_t>(senderId) << 32 | receiverId));
+  return splitMix64(h ^ tick);
+}
@@ -0,0 +1,157 @@
+/**
+ * @file V2VBus.hpp
+ * @author @jonatechout
+ * @brief Simulated vehicle-to-vehicle communication with latency, jitter and loss.
+ */
+#ifndef V2VBUS_H
+#define V2VBUS_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include "Car.hpp"
+
+/**
+ * @class V2VBus
+ * @brief Simulated vehicle-to-vehicle communication with latency, jitter and loss.
+ * Each vehicle owns a ring of mailboxes, one per tick, which is allocated once in init().
+ * A vehicle publishes at most one message per tick into its own ring, so publishing never blocks
+ * and different vehicles can publish and receive from different threads.
+ * Delay and loss of each message (sender, receiver, sent tick) are drawn once from a seeded hash, so they are
+ * reproducible and independent of the update order, and every message arrives at one tick unless it is lost.
+ * A vehicle which does not publish at a tick (e.g. sleeping in EventScheduler) repeats its last message.
+ */
+class V2VBus
+{
+public:
+  struct StateMessage
+  {
+    uint32_t senderId; ///< Vehicle ID of sender
+    uint32_t tick;     ///< Tick when the message was published
+    double x;          ///< X [m] (world coordinate)
+    double y;          ///< Y [m] (world coordinate)
+    float velocity;    ///< Velocity [m/s]
+    float accel;       ///< Acceleration [m/s^2]
+    float heading;     ///< Heading angle [rad]
+  };
+
+  V2VBus();
+  virtual ~V2VBus();
+
+  /**
+   * @brief Set the channel characteristics. Must be called before init().
+   *
+   * @param latency Base latency [s]
+   * @param jitter Maximum additional latency [s] (uniformly distributed)
+   * @param dropRate Probability of losing a message [0-1]
+   */
+  void setChannel(double latency, double jitter, double dropRate);
+
+  /**
+   * @brief Set the random seed of delay and loss.
+   *
+   * @param seed
+   */
+  void setSeed(uint64_t seed);
+
+  /**
+   * @brief Allocate mailboxes.
+   *
+   * @param vehicleNum Number of vehicles (IDs are 0 to vehicleNum - 1)
+   * @param period Tick period [s]
+   */
+  void init(unsigned int vehicleNum, double period);
+
+  /**
+   * @brief Start the next tick. Call once per tick before vehicles publish.
+   */
+  void advance();
+
+  /**
+   * @brief Jump to given tick (e.g. when no vehicle is updated in between).
+   *
+   * @param tick Tick, must not be smaller than the current tick
+   */
+  void advanceTo(unsigned int tick);
+
+  /**
+   * @brief Publish the state of a vehicle for the current tick.
+   *
+   * @param senderId Vehicle ID
+   * @param car State to publish
+   */
+  void publish(unsigned int senderId, const Car &car);
+
+  /**
+   * @brief Receive the newest message from sender which has arrived by the current tick.
+   * Messages overtaken by a newer one because of jitter are never returned.
+   *
+   * @param senderId Vehicle ID of sender
+   * @param receiverId Vehicle ID of receiver
+   * @param out_message Received message
+   * @return true  A message has arrived.
+   * @return false  Nothing arrived within latency + jitter (not sent yet, delayed or lost).
+   */
+  bool receive(unsigned int senderId, unsigned int receiverId, StateMessage *out_message) const;
+
+  unsigned int tick() const { return _tick.load(std::memory_order_acquire); }
+  unsigned int vehicleNum() const { return _vehicleNum; }
+
+  /**
+   * @brief Returns bytes of mailboxes and publisher states.
+   */
+  size_t memoryUsage() const { return _vehicleNum * (_depth * sizeof(Mailbox) + sizeof(PublisherState)); }
+
+protected:
+  struct Mailbox
+  {
+    std::atomic<uint32_t> sequence; ///< tick + 1 of the stored message (0: empty or being written)
+    StateMessage message;           ///< Stored message
+  };
+
+  struct PublisherState
+  {
+    std::atomic<uint32_t> tick; ///< Tick of the last published message (0: never published)
+    float velocity;             ///< Velocity of the last published message [m/s]
+  };
+
+  /**
+   * @brief Read the message published by sender at given tick.
+   *
+   * @return true  The message is in the mailbox.
+   * @return false  Not published at the tick, or already overwritten.
+   */
+  bool readMailbox(unsigned int senderId, unsigned int tick, StateMessage *out_message) const;
+
+  /**
+   * @brief Returns the delay of the message sent at given tick [tick].
+   */
+  unsigned int messageDelay(unsigned int senderId, unsigned int receiverId, unsigned int sentTick) const;
+
+  /**
+   * @brief Returns true if the message sent at given tick is lost.
+   */
+  bool isDropped(unsigned int senderId, unsigned int receiverId, unsigned int sentTick) const;
+
+  /**
+   * @brief Returns a pseudo random number for given link and tick.
+   */
+  uint64_t hash(unsigned int senderId, unsigned int receiverId, unsigned int tick, uint64_t salt) const;
+
+  double _latency;            ///< Base latency [s]
+  double _jitter;             ///< Maximum additional latency [s]
+  double _dropRate;           ///< Probability of losing a message
+  uint64_t _seed;             ///< Random seed
+
+  unsigned int _latencyTicks; ///< Base latency [tick]
+  unsigned int _jitterTicks;  ///< Maximum additional latency [tick]
+  unsigned int _depth;        ///< Number of mailboxes per vehicle
+  unsigned int _vehicleNum;   ///< Number of vehicles
+  double _period;             ///< Tick period [s]
+
+  std::atomic<uint32_t> _tick;                   ///< Current tick
+  std::unique_ptr<Mailbox[]> _mailboxes;         ///< Mailboxes of all vehicles (vehicleNum x depth)
+  std::unique_ptr<PublisherState[]> _publishers; ///< Last published state of each vehicle
+};
+
+#endif
@@ -50,9 +50,27 @@ void Visualizer::addPath(const VisLine &line)
   _lines.push_back(line);
 }
 
+size_t Visualizer::memoryUsage() const
+{
+  size_t bytes = _objects.capacity() * sizeof(VisCar) + _lines.capacity() * sizeof(VisLine);
+  for (const auto &line : _lines)
+  {
+    bytes += line.points.capacity() * sizeof(VisPoint);
+  }
+
+  return bytes;
+}
+
 void Visualizer::getImage(cv::Mat *out_img)
 {
-  (*out_img) = cv::Mat::zeros(cv::Size(_imageSize.x, _imageSize.y), CV_8UC3);
+  (*out_img) = cv::Mat(cv::Size(_imageSize.x, _imageSize.y), CV_8UC3);
+
+  drawImage(out_img);
+}
+
+void Visualizer::drawImage(cv::Mat *out_img)
+{
+  out_img->setTo(cv::Scalar::all(0));
 
   drawGrid(*out_img);
 
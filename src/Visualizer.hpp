@@ -61,6 +61,13 @@ public:
    */
   void getImage(cv::Mat *out_img);
 
+  /**
+   * @brief Draw into an image already allocated with the image size (e.g. a region of a larger image).
+   * The image is cleared first. Pixels outside of the image are not touched.
+   * @param out_img output image
+   */
+  void drawImage(cv::Mat *out_img);
+
   /**
    * @brief Clear all the objects.
    */
@@ -84,6 +91,11 @@ public:
    */
   void setScale(double scale);
 
+  /**
+   * @brief Returns bytes of objects and lines to visualize.
+   */
+  size_t memoryUsage() const;
+
 protected:
   /**
    * @brief Convert world coordinate into visualizer coordinarte
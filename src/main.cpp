@@ -10,19 +10,60 @@
  */
 
 #include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <algorithm>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include "Visualizer.hpp"
+#include "TiledDashboard.hpp"
 #include "PlaybackCar.hpp"
-#include "SimCar.hpp"
+#include "InsLoader.hpp"
+#include "TrajectoryPlayer.hpp"
+#include "EnsembleRunner.hpp"
+#include "Scenario.hpp"
+#include "Simulation.hpp"
+#include "RegressionRunner.hpp"
+#include "MemoryReport.hpp"
 #include "Car.hpp"
 
 using namespace std;
 using namespace std::chrono;
 
+volatile sig_atomic_t g_interrupted = 0; ///< Set by Ctrl+C to leave the main loop
+
+/**
+ * @brief Signal handler of SIGINT
+ *
+ * @param signum
+ */
+void onInterrupt(int signum)
+{
+  (void)signum;
+  g_interrupted = 1;
+}
+
+/**
+ * @brief Prints memory footprint of the simulation and the visualizer
+ *
+ * @param sim
+ * @param visualizerBytes Bytes of the visualizer or the dashboard
+ */
+void printMemoryUsage(const Simulation &sim, size_t visualizerBytes)
+{
+  MemoryReport report;
+  sim.getMemoryUsage(&report);
+  report.add("visualizer", visualizerBytes);
+
+  report.print(cout, sim.cars().size());
+}
+
 /**
  * @brief Converts Car object to visualizer position
  *
@@ -62,108 +103,487 @@ Visualizer::VisLine convertPathToVisLine(const vector<PlaybackCar::PositionData>
   return visline;
 }
 
+/**
+ * @brief Initializes a dashboard with a tile for each ego car, which shows the path and lanes of the ego car
+ * Tiles share the window size of the scenario.
+ *
+ * @param sim
+ * @param columnNum Number of tiles in a row
+ * @param out_dashboard
+ */
+void initDashboard(const Simulation &sim, unsigned int columnNum, TiledDashboard *out_dashboard)
+{
+  const Scenario &scenario = sim.scenario();
+  unsigned int tileNum = sim.egoCarNum();
+  columnNum = max(min(columnNum, tileNum), 1u);
+  unsigned int rowNum = (tileNum + columnNum - 1) / columnNum;
+
+  out_dashboard->init(tileNum, columnNum, scenario.windowWidth / columnNum, scenario.windowHeight / rowNum,
+                      scenario.scale / columnNum);
+
+  // Lanes are listed for each ego car in order
+  unsigned int laneNum = sim.lanePaths().size() / tileNum;
+  for (unsigned int k = 0; k < tileNum; k++)
+  {
+    out_dashboard->tile(k).addPath(convertPathToVisLine(sim.paths().at(k)));
+
+    for (unsigned int lane = 0; lane < laneNum; lane++)
+    {
+      out_dashboard->tile(k).addPath(convertPathToVisLine(sim.lanePaths().at(k * laneNum + lane)));
+    }
+  }
+}
+
+/**
+ * @brief Splits comma separated file list
+ *
+ * @param arg
+ * @return vector<string> File paths
+ */
+vector<string> splitFileList(const string &arg)
+{
+  vector<string> files;
+  string item;
+  istringstream stream(arg);
+
+  while (getline(stream, item, ','))
+  {
+    if (!item.empty())
+    {
+      files.push_back(item);
+    }
+  }
+
+  return files;
+}
+
+/**
+ * @brief Returns true if given argument is an integer
+ *
+ * @param arg
+ */
+bool isInteger(const char *arg)
+{
+  char *end = nullptr;
+  strtol(arg, &end, 10);
+
+  return end != arg && *end == '\0';
+}
+
+/**
+ * @brief Converts recorded vehicle state to visualizer position
+ *
+ * @param state
+ * @return Visualizer::VisCar
+ */
+Visualizer::VisCar convertStateToVisCar(const TrajectoryFormat::VehicleState &state)
+{
+  Visualizer::VisCar viscar;
+  viscar.position.x = state.x;
+  viscar.position.y = state.y;
+  viscar.velocity = state.velocity;
+  viscar.heading = state.heading;
+
+  return viscar;
+}
+
+/**
+ * @brief Replays a recorded trajectory file
+ * Keys: space = pause/resume, f = fast-forward (x2 each), r = reverse, n = normal speed,
+ * . and , = step forward/backward, ] and [ = skip 10 sec forward/backward, 0-9 = jump to 0%-90%, q = quit
+ *
+ * @param filepath
+ * @return int Exit code
+ */
+int replayRecording(const string &filepath)
+{
+  const int maxSpeed = 64; //Maximum fast-forward speed
+  const double skipTime = 10.0; //Time to skip with [ and ] [sec]
+
+  TrajectoryPlayer player;
+  if (!player.open(filepath))
+  {
+    return -1;
+  }
+
+  if (player.frameNum() == 0)
+  {
+    cout << "No frame in file: " << filepath << endl;
+    return -1;
+  }
+
+  Visualizer vis;
+  vis.init(player.windowWidth(), player.windowHeight(), player.windowWidth() / 2, player.windowHeight() / 2, player.scale());
+
+  vector<vector<PlaybackCar::PositionData> > paths;
+  player.getPaths(&paths);
+  for (const auto &path : paths)
+  {
+    vis.addPath(convertPathToVisLine(path));
+  }
+
+  cv::namedWindow("platoondemo", CV_WINDOW_AUTOSIZE);
+
+  int loopCycleMSec = static_cast<int>(player.period() * 1000);
+  steady_clock::time_point nextTime = steady_clock::now() + milliseconds(loopCycleMSec);
+
+  const long long lastFrame = player.frameNum() - 1;
+  const long long skipFrame = static_cast<long long>(skipTime / player.period());
+  long long frame = 0;
+  int speed = 1; // Frames to advance per loop (negative: reverse)
+  bool paused = false;
+
+  while (1)
+  {
+    // Frames have a fixed size, any frame is accessed directly
+    const TrajectoryFormat::VehicleState *vehicles = player.vehicles(frame);
+
+    vis.clearObjects();
+    for (unsigned int i = 0; i < player.vehicleNum(); i++)
+    {
+      vis.addObject(convertStateToVisCar(vehicles[i]));
+    }
+
+    // First ego car is the first vehicle
+    vis.setCameraPosition(vehicles[0].x, vehicles[0].y);
+
+    cv::Mat image;
+    vis.getImage(&image);
+
+    ostringstream status;
+    status << (paused ? "pause" : "x" + to_string(speed)) << "  " << fixed << setprecision(1) << player.frameTime(frame) << " s";
+    cv::putText(image, status.str(), cv::Point2d(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255));
+
+    cv::imshow("platoondemo", image);
+    int key = cv::waitKey(1);
+
+    switch (key)
+    {
+    case ' ':
+      paused = !paused;
+      break;
+    case 'f':
+      speed = (speed > 0) ? min(speed * 2, maxSpeed) : 1;
+      paused = false;
+      break;
+    case 'r':
+      speed = -speed;
+      paused = false;
+      break;
+    case 'n':
+      speed = 1;
+      paused = false;
+      break;
+    case '.':
+      frame++;
+      paused = true;
+      break;
+    case ',':
+      frame--;
+      paused = true;
+      break;
+    case ']':
+      frame += skipFrame;
+      break;
+    case '[':
+      frame -= skipFrame;
+      break;
+    case 'q':
+    case 27:
+      return 0;
+    default:
+      if (key >= '0' && key <= '9')
+      {
+        frame = lastFrame * (key - '0') / 10;
+      }
+      break;
+    }
+
+    if (!paused)
+    {
+      frame += speed;
+    }
+
+    frame = min(max(frame, 0LL), lastFrame);
+
+    // Sleep until next time step
+    this_thread::sleep_until(nextTime);
+    nextTime += milliseconds(loopCycleMSec);
+  }
+}
+
 /**
  * @brief Main function
- * INS data file path must be provided as 1st argument.
+ * INS data file path must be provided as 1st argument. A drive split into several files can be given as comma separated list.
  * Number of following cars can be provided as 2nd argument. If not, default value is 2.
+ * Additional drives can be provided after that, each of them leads its own followers.
+ * Options:
+ *  -s <file> : load a scenario file instead of INS files and # of followers
+ *  -t <port or socket path> : stream telemetry over localhost TCP or Unix domain socket
+ *  -r <file> : record the states of all the cars
+ *  -p <file> : replay a recorded file (INS files are not needed)
+ *  -m <# of members> : run perturbed copies of the first drive without visualization and print statistics as CSV
+ *  -R <directory> : run all the scenario files in a directory without visualization and compare with baselines
+ *  -u : with -R, write the current metrics as baselines
+ *  -M <interval sec> : print memory footprint of each subsystem periodically (0: only at exit)
+ *  -T <# of columns> : show a tiled dashboard with a view of each ego car instead of the view of the first ego car
+ * Memory footprint is also printed at exit (end of the scenario or Ctrl+C).
  */
 int main(int argc, char *argv[])
 {
-  const double period = 0.02;
+  string scenarioFile;
+  string telemetryEndpoint;
+  string recordFile;
+  string replayFile;
+  string regressionDir;
+  bool updateBaseline = false;
+  int memberNum = 0;
+  double memoryInterval = 0.0;
+  int tileColumnNum = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:t:r:p:m:R:uM:T:")) != -1)
+  {
+    if (opt == 's')
+    {
+      scenarioFile = optarg;
+    }
+    else if (opt == 't')
+    {
+      telemetryEndpoint = optarg;
+    }
+    else if (opt == 'r')
+    {
+      recordFile = optarg;
+    }
+    else if (opt == 'p')
+    {
+      replayFile = optarg;
+    }
+    else if (opt == 'm' && isInteger(optarg) && atoi(optarg) > 0)
+    {
+      memberNum = atoi(optarg);
+    }
+    else if (opt == 'R')
+    {
+      regressionDir = optarg;
+    }
+    else if (opt == 'u')
+    {
+      updateBaseline = true;
+    }
+    else if (opt == 'M' && atof(optarg) >= 0.0)
+    {
+      memoryInterval = atof(optarg);
+    }
+    else if (opt == 'T' && isInteger(optarg) && atoi(optarg) > 0)
+    {
+      tileColumnNum = atoi(optarg);
+    }
+    else
+    {
+      argc = 0;
+    }
+  }
 
-  if (argc < 2)
+  if (argc > 0 && !replayFile.empty())
   {
-    cout << argv[0] << " <INS file name> [<# of followers>]" << endl;
-    return -1;
+    return replayRecording(replayFile);
+  }
+
+  if (argc > 0 && !regressionDir.empty())
+  {
+    RegressionRunner runner;
+    return runner.run(regressionDir, updateBaseline) ? 0 : 1;
   }
 
-  const char* dataFileName = argv[1];
-  int followerNum = 2;
-  if (argc >= 3)
+  if (argc - optind < 1 && (argc == 0 || scenarioFile.empty()))
   {
-    followerNum = atoi(argv[2]);
+    cout << argv[0] << " [-t <port or socket path>] [-r <record file>] [-m <# of members>] [-M <interval sec>] [-T <# of columns>] <INS file name>[,<INS file name>...] [<# of followers>] [<INS file name>[,<INS file name>...] ...]" << endl;
+    cout << argv[0] << " [-t <port or socket path>] [-r <record file>] [-m <# of members>] [-M <interval sec>] [-T <# of columns>] -s <scenario file>" << endl;
+    cout << argv[0] << " -R <scenario directory> [-u]" << endl;
+    cout << argv[0] << " -p <record file>" << endl;
+    return -1;
+  }
 
-    if (followerNum < 0)
+  Scenario scenario;
+  if (!scenarioFile.empty())
+  {
+    if (!scenario.load(scenarioFile))
     {
-      cout << "# of followers must be positive." << endl;
       return -1;
     }
   }
-
-  // Ego car loads INS data from data file
-  PlaybackCar egoCar;
-  if (!egoCar.setData(dataFileName))
+  else
   {
-    cout << "Failed to load data." << endl;
-    return -1;
+    vector<vector<string> > drives(1, splitFileList(argv[optind]));
+    int followerNum = 2;
+    for (int i = optind + 1; i < argc; i++)
+    {
+      if (i == optind + 1 && isInteger(argv[i]))
+      {
+        followerNum = atoi(argv[i]);
+
+        if (followerNum < 0)
+        {
+          cout << "# of followers must be positive." << endl;
+          return -1;
+        }
+      }
+      else
+      {
+        drives.push_back(splitFileList(argv[i]));
+      }
+    }
+
+    for (const auto &files : drives)
+    {
+      scenario.addLeader(files, followerNum);
+    }
   }
 
-  egoCar.setPeriod(period);
-  egoCar.initKalman();
+  // Command line options override the output sinks of the scenario
+  if (!telemetryEndpoint.empty())
+  {
+    scenario.telemetryEndpoint = telemetryEndpoint;
+  }
 
-  // Get a whole path data (thined out) for visualization
-  vector<PlaybackCar::PositionData> pathData;
-  egoCar.getWholePath(&pathData, 2.0);
+  if (!recordFile.empty())
+  {
+    scenario.recordFile = recordFile;
+  }
 
-  // Initialize following cars
-  vector<SimCar> simCarVec(followerNum);
-  for (unsigned int i = 0; i < simCarVec.size(); i++)
+  if (memberNum > 0)
   {
-    simCarVec.at(i).init(pathData.at(0).x, pathData.at(0).y, 0, 0);
-    simCarVec.at(i).setPeriod(period);
+    // Monte Carlo ensemble of the first drive
+    const Scenario::LeaderConfig &leader = scenario.leaders.front();
 
-    if (i == 0)
+    vector<PlaybackCar::PositionData> data;
+    InsLoader loader;
+    if (!loader.load(leader.files, &data))
     {
-      // First one follows ego car
-      simCarVec.at(i).setLeadingCar(&egoCar);
+      cout << "Failed to load data." << endl;
+      return -1;
     }
-    else
+
+    EnsembleRunner ensemble;
+    ensemble.setMemberNum(memberNum);
+    if (!ensemble.setScenario(scenario))
+    {
+      return -1;
+    }
+
+    vector<EnsembleRunner::SampleStatistics> stats;
+    if (!ensemble.run(data, scenario.duration, &stats))
     {
-      // Follows the previous following car
-      simCarVec.at(i).setLeadingCar(&simCarVec.at(i - 1));
+      cout << "No data in drive: " << leader.files.front() << endl;
+      return -1;
     }
+
+    EnsembleRunner::writeCsv(stats, cout);
+    return 0;
+  }
+
+  Simulation sim;
+  if (!sim.init(scenario, true))
+  {
+    return -1;
   }
 
-  // Initialize visualization
+  // Initialize visualization (view of the first ego car, or dashboard of all the ego cars)
   Visualizer vis;
-  vis.init(1000, 800, 500, 400, 5.0);
-  vis.addPath(convertPathToVisLine(pathData));
+  TiledDashboard dashboard;
+  if (tileColumnNum > 0)
+  {
+    initDashboard(sim, tileColumnNum, &dashboard);
+  }
+  else
+  {
+    vis.init(scenario.windowWidth, scenario.windowHeight, scenario.windowWidth / 2, scenario.windowHeight / 2, scenario.scale);
+    for (const auto &path : sim.paths())
+    {
+      vis.addPath(convertPathToVisLine(path));
+    }
+
+    for (const auto &path : sim.lanePaths())
+    {
+      vis.addPath(convertPathToVisLine(path));
+    }
+  }
 
   cv::namedWindow("platoondemo", CV_WINDOW_AUTOSIZE);
 
-  int loopCycleMSec = static_cast<int>(period * 1000);
+  // Ctrl+C leaves the loop, so the metrics and memory footprint are written at exit
+  signal(SIGINT, onInterrupt);
+
+  int loopCycleMSec = static_cast<int>(scenario.period * 1000);
   steady_clock::time_point nextTime = steady_clock::now() + milliseconds(loopCycleMSec);
+  double nextMemoryReportTime = memoryInterval;
 
-  // Main loop
-  while (1)
+  // Main loop (runs until closed, unless the scenario has a duration)
+  while (!g_interrupted && (scenario.duration <= 0.0 || !sim.isFinished()))
   {
-    vis.clearObjects();
-
-    // Update the state of ego car
-    egoCar.update();
+    // Update the state of cars which are awake
+    sim.step();
 
-    // Add current object to visualizer
-    vis.addObject(convertCarToVisCar(egoCar));
+    steady_clock::time_point renderStart = steady_clock::now();
 
-    // Update the state of following car and add them to visualizer
-    for (auto&& car = simCarVec.begin(); car != simCarVec.end(); car++)
+    cv::Mat image;
+    if (tileColumnNum > 0)
     {
-      car->update();
-      vis.addObject(convertCarToVisCar(*car));
+      // Each car is shown in the tile of the ego car it started with
+      for (unsigned int k = 0; k < dashboard.tileNum(); k++)
+      {
+        dashboard.tile(k).clearObjects();
+        dashboard.tile(k).setCameraPosition(sim.egoCar(k).x(), sim.egoCar(k).y());
+      }
+
+      for (unsigned int id = 0; id < sim.cars().size(); id++)
+      {
+        dashboard.tile(sim.egoIndex(id)).addObject(convertCarToVisCar(*sim.cars().at(id)));
+      }
+
+      // Tiles are rendered in parallel
+      dashboard.getImage(&image);
     }
+    else
+    {
+      // Add cars to visualizer
+      vis.clearObjects();
+      for (const auto &car : sim.cars())
+      {
+        vis.addObject(convertCarToVisCar(*car));
+      }
 
-    // Set ego car position to Visualizer's center position
-    vis.setCameraPosition(egoCar.x(), egoCar.y());
+      // Set first ego car position to Visualizer's center position
+      vis.setCameraPosition(sim.egoCar(0).x(), sim.egoCar(0).y());
 
-    // Generate visualizaion image
-    cv::Mat image;
-    vis.getImage(&image);
+      // Generate visualizaion image
+      vis.getImage(&image);
+    }
 
     cv::imshow("platoondemo", image);
     cv::waitKey(1);
 
+    sim.publishTelemetry(duration<float, milli>(steady_clock::now() - renderStart).count());
+
+    if (memoryInterval > 0.0 && sim.currentTime() >= nextMemoryReportTime)
+    {
+      printMemoryUsage(sim, vis.memoryUsage() + dashboard.memoryUsage());
+      nextMemoryReportTime += memoryInterval;
+    }
+
     // Sleep until next time step
     this_thread::sleep_until(nextTime);
     nextTime += milliseconds(loopCycleMSec);
   }
+
+  printMemoryUsage(sim, vis.memoryUsage() + dashboard.memoryUsage());
+
+  if (!scenario.metricsFile.empty())
+  {
+    sim.updateMemoryMetrics();
+    sim.writeMetrics(scenario.metricsFile);
+  }
+
+  return 0;
 }
@@ -0,0 +1,130 @@
+/**
+ * @file kernel_accuracy.cpp
+ * @author @jonatechout
+ * @brief Accuracy check of the fast math kernel (make accuracy).
+ *
+ * The math kernel is selected at compile time, so this tool is built twice, with and without PLATOON_FAST_MATH.
+ * Both builds run the same scenario and record the trajectories, then the recordings are compared frame by frame.
+ *
+ * kernel_accuracy run "scenario file" "record file"
+ *  Runs the scenario without visualization, telemetry and metrics, and records all the cars.
+ *
+ * kernel_accuracy compare "exact record file" "fast record file" "position tolerance [m]" "heading tolerance [rad]"
+ *  Prints the maximum position and heading deviation of each car. Exit code is 1 if any of them exceeds the tolerance.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "Scenario.hpp"
+#include "Simulation.hpp"
+#include "TrajectoryPlayer.hpp"
+
+using namespace std;
+
+namespace
+{
+int runScenario(const string &scenarioFile, const string &recordFile)
+{
+  Scenario scenario;
+  if (!scenario.load(scenarioFile))
+  {
+    return 1;
+  }
+
+  // Only the trajectories are compared, the reference run would just double the run time
+  scenario.recordFile = recordFile;
+  scenario.telemetryEndpoint.clear();
+  scenario.metricsFile.clear();
+  scenario.referenceSubstep = 0.0;
+
+  Simulation sim;
+  if (!sim.init(scenario, true))
+  {
+    return 1;
+  }
+
+  sim.run();
+
+  return 0;
+}
+
+int compareRecords(const string &exactFile, const string &fastFile, double positionTolerance, double headingTolerance)
+{
+  TrajectoryPlayer exact;
+  TrajectoryPlayer fast;
+  if (!exact.open(exactFile) || !fast.open(fastFile))
+  {
+    return 1;
+  }
+
+  if (exact.vehicleNum() != fast.vehicleNum() || exact.frameNum() != fast.frameNum())
+  {
+    cout << "Recordings differ: " << exact.vehicleNum() << " cars x " << exact.frameNum() << " frames vs "
+         << fast.vehicleNum() << " cars x " << fast.frameNum() << " frames" << endl;
+    return 1;
+  }
+
+  unsigned int vehicleNum = exact.vehicleNum();
+  vector<double> maxPosition(vehicleNum, 0.0);
+  vector<double> maxHeading(vehicleNum, 0.0);
+
+  for (unsigned long long frame = 0; frame < exact.frameNum(); frame++)
+  {
+    const TrajectoryFormat::VehicleState *a = exact.vehicles(frame);
+    const TrajectoryFormat::VehicleState *b = fast.vehicles(frame);
+
+    for (unsigned int i = 0; i < vehicleNum; i++)
+    {
+      double position = hypot(a[i].x - b[i].x, a[i].y - b[i].y);
+      double heading = fabs(remainder(static_cast<double>(a[i].heading) - b[i].heading, 2.0 * M_PI)); //[-pi, pi]
+
+      maxPosition.at(i) = fmax(maxPosition.at(i), position);
+      maxHeading.at(i) = fmax(maxHeading.at(i), heading);
+    }
+  }
+
+  double worstPosition = 0.0;
+  double worstHeading = 0.0;
+
+  cout << "car, max position deviation [m], max heading deviation [rad]" << endl;
+  cout << scientific << setprecision(3);
+  for (unsigned int i = 0; i < vehicleNum; i++)
+  {
+    cout << i << ", " << maxPosition.at(i) << ", " << maxHeading.at(i) << endl;
+    worstPosition = fmax(worstPosition, maxPosition.at(i));
+    worstHeading = fmax(worstHeading, maxHeading.at(i));
+  }
+
+  bool passed = worstPosition <= positionTolerance && worstHeading <= headingTolerance;
+  cout << (passed ? "PASS" : "FAIL") << ": " << exact.frameNum() << " frames, position " << worstPosition
+       << " m (tolerance " << positionTolerance << "), heading " << worstHeading << " rad (tolerance "
+       << headingTolerance << ")" << endl;
+
+  return passed ? 0 : 1;
+}
+}
+
+int main(int argc, char *argv[])
+{
+  string mode = (argc > 1) ? argv[1] : "";
+
+  if (mode == "run" && argc == 4)
+  {
+    return runScenario(argv[2], argv[3]);
+  }
+
+  if (mode == "compare" && argc == 6)
+  {
+    return compareRecords(argv[2], argv[3], atof(argv[4]), atof(argv[5]));
+  }
+
+  cout << "Usage: " << argv[0] << " run \"scenario file\" \"record file\"" << endl;
+  cout << "       " << argv[0] << " compare \"exact record file\" \"fast record file\" "
+       << "\"position tolerance [m]\" \"heading tolerance [rad]\"" << endl;
+
+  return 1;
+}